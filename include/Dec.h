@@ -0,0 +1,163 @@
+#pragma once
+
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef int64_t Dec;
+
+static const uint8_t DEC_FRAC = 8;
+static const Dec DEC_SCALE = 100000000LL;
+static const Dec DEC_POW10[DEC_FRAC + 1] = {
+  1LL, 10LL, 100LL, 1000LL, 10000LL, 100000LL, 1000000LL, 10000000LL, 100000000LL
+};
+static const double DEC_LIMIT = 9.2e10;
+
+static constexpr Dec decFromDouble(double v) {
+  return (Dec)(v * 1e8 + (v < 0 ? -0.5 : 0.5));
+}
+
+static inline bool decParse(const char* s, Dec& out) {
+  while (*s == ' ' || *s == '"') s++;
+  const char* start = s;
+  bool neg = (*s == '-');
+  if (*s == '-' || *s == '+') s++;
+
+  Dec whole = 0;
+  uint8_t wholeDigits = 0;
+  while (*s >= '0' && *s <= '9') {
+    if (++wholeDigits > 10) return false;
+    whole = whole * 10 + (*s++ - '0');
+  }
+
+  Dec frac = 0;
+  uint8_t fracDigits = 0;
+  bool roundUp = false;
+  if (*s == '.') {
+    s++;
+    while (*s >= '0' && *s <= '9') {
+      if (fracDigits < DEC_FRAC) frac = frac * 10 + (*s - '0');
+      else if (fracDigits == DEC_FRAC) roundUp = (*s >= '5');
+      if (fracDigits <= DEC_FRAC) fracDigits++;
+      s++;
+    }
+  }
+  if (wholeDigits == 0 && fracDigits == 0) return false;
+
+  if (*s == 'e' || *s == 'E') {
+    double v = strtod(start, nullptr);
+    if (!(fabs(v) < DEC_LIMIT)) return false;
+    out = decFromDouble(v);
+    return true;
+  }
+
+  if (fracDigits > DEC_FRAC) fracDigits = DEC_FRAC;
+  Dec v = whole * DEC_SCALE + frac * DEC_POW10[DEC_FRAC - fracDigits] + (roundUp ? 1 : 0);
+  out = neg ? -v : v;
+  return true;
+}
+
+static inline bool scanDec(const char* body, const char* key, Dec& out) {
+  size_t klen = strlen(key);
+  const char* p = body;
+  while ((p = strchr(p, '"')) != nullptr) {
+    p++;
+    if (strncmp(p, key, klen) != 0 || p[klen] != '"') continue;
+    p += klen + 1;
+    while (*p == ' ') p++;
+    if (*p != ':') continue;
+    p++;
+    while (*p == ' ') p++;
+    return decParse(p, out);
+  }
+  return false;
+}
+
+static inline Dec decMul(Dec a, Dec b) {
+  bool neg = (a < 0) != (b < 0);
+  uint64_t x = (a < 0) ? -(uint64_t)a : (uint64_t)a;
+  uint64_t y = (b < 0) ? -(uint64_t)b : (uint64_t)b;
+  uint64_t xh = x / DEC_SCALE, xl = x % DEC_SCALE;
+  uint64_t yh = y / DEC_SCALE, yl = y % DEC_SCALE;
+  uint64_t r = xh * yh * DEC_SCALE + xh * yl + xl * yh + (xl * yl + DEC_SCALE / 2) / DEC_SCALE;
+  return neg ? -(Dec)r : (Dec)r;
+}
+
+static inline Dec decDiv(Dec a, Dec b) {
+  if (b == 0) return 0;
+  bool neg = (a < 0) != (b < 0);
+  uint64_t x = (a < 0) ? -(uint64_t)a : (uint64_t)a;
+  uint64_t y = (b < 0) ? -(uint64_t)b : (uint64_t)b;
+  uint64_t q = x / y;
+  uint64_t r = x % y;
+  for (uint8_t i = 0; i < DEC_FRAC; i++) {
+    r *= 10;
+    q = q * 10 + r / y;
+    r %= y;
+  }
+  if (r * 2 >= y) q++;
+  return neg ? -(Dec)q : (Dec)q;
+}
+
+static inline size_t decFormat(char* out, size_t len, Dec v, uint8_t d, char sep = 0) {
+  if (len == 0) return 0;
+  if (d > DEC_FRAC) d = DEC_FRAC;
+
+  bool neg = (v < 0);
+  uint64_t x = neg ? -(uint64_t)v : (uint64_t)v;
+  uint64_t unit = DEC_POW10[DEC_FRAC - d];
+  x = (x + unit / 2) / unit;
+  if (x == 0) neg = false;
+
+  char tmp[40];
+  uint8_t n = 0;
+  for (uint8_t i = 0; i < d; i++) {
+    tmp[n++] = '0' + (char)(x % 10);
+    x /= 10;
+  }
+  if (d) tmp[n++] = '.';
+  uint8_t group = 0;
+  do {
+    if (sep && group == 3) {
+      tmp[n++] = sep;
+      group = 0;
+    }
+    tmp[n++] = '0' + (char)(x % 10);
+    x /= 10;
+    group++;
+  } while (x);
+  if (neg) tmp[n++] = '-';
+
+  size_t w = 0;
+  while (n > 0 && w + 1 < len) out[w++] = tmp[--n];
+  out[w] = 0;
+  return w;
+}
+
+static inline void decCompose(char* out, size_t len, const char* pre, Dec v, uint8_t d, char sep, const char* post) {
+  if (len == 0) return;
+  char num[32];
+  size_t n = decFormat(num, sizeof(num), v, d, sep);
+  size_t a = strlen(pre), b = strlen(post);
+  if (a + n + b >= len) {
+    out[0] = 0;
+    return;
+  }
+  memcpy(out, pre, a);
+  memcpy(out + a, num, n);
+  memcpy(out + a + n, post, b + 1);
+}
+
+static inline void formatPrice(char* out, size_t len, Dec v, uint8_t d) {
+  if (d > 6) d = 6;
+  decCompose(out, len, "$", v, d, ',', "");
+}
+
+static inline void formatPL(char* out, size_t len, Dec v) {
+  decCompose(out, len, (v >= 0) ? "+$" : "-$", (v >= 0) ? v : -v, 2, ',', "");
+}
+
+static inline void formatPercent(char* out, size_t len, Dec pct) {
+  decCompose(out, len, (pct >= 0) ? "+" : "-", (pct >= 0) ? pct : -pct, 2, 0, "%");
+}
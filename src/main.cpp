@@ -3,13 +3,22 @@
 #include <WiFiManager.h>
 #include <ESP8266HTTPClient.h>
 #include <WiFiClientSecureBearSSL.h>
+#include <lwip/dns.h>
+#include <lwip/tcp.h>
+#include <include/ClientContext.h>
+#define ARDUINOJSON_USE_DOUBLE 1
 #include <ArduinoJson.h>
 #include <TFT_eSPI.h>
 #include <EEPROM.h>
+#include <TimeLib.h>
+#include <time.h>
+#include <sys/time.h>
+#include "Dec.h"
 
 TFT_eSPI tft;
 ESP8266WebServer server(80);
 WiFiClient wifiClient;
+WiFiClient streamClient;
 
 #define TFT_W 240
 #define TFT_H 240
@@ -18,28 +27,338 @@ WiFiClient wifiClient;
 #define TFT_BL 5
 #endif
 
-static const uint32_t REFRESH_MS = 15000;
 static const uint32_t SYS_PUSH_MS = 10UL * 60UL * 1000UL;
 
-uint32_t lastFetch = 0;
+static const uint32_t DRAW_MIN_MS = 250;
+static const uint32_t FRAME_MS = 50;
+static const uint32_t IDLE_WINDOW_MS = 1000;
+
+static const int16_t TZ_DEFAULT_MIN = 8 * 60;
+static const time_t NTP_VALID_AFTER = 1600000000;
+static const time_t NTP_RETRY_S = 10;
+static const time_t NTP_SYNC_S = 3600;
+
 uint32_t lastSysPush = 0;
+uint32_t lastDraw = 0;
+bool wifiUp = false;
+uint32_t heapLow = UINT32_MAX;
+uint32_t blockLow = UINT32_MAX;
+bool clockSettled = false;
+
+uint32_t apiConnOpened = 0;
+uint32_t apiConnReused = 0;
+uint32_t apiConnDropped = 0;
+uint32_t apiNotModified = 0;
+
+bool streamUp = false;
+uint32_t streamConnects = 0;
+uint32_t streamEvents = 0;
+
+struct Prefetch {
+  uint32_t windowAt;
+  uint32_t lastAt;
+  uint16_t reqs;
+  uint32_t bytes;
+  uint32_t totalReqs;
+  uint32_t totalBytes;
+};
+
+static Prefetch pf;
+
+enum BreakerState : uint8_t { BR_CLOSED, BR_OPEN, BR_HALF_OPEN };
+static const char* const BREAKER_NAMES[] = {"closed", "open", "half_open"};
+
+struct Breaker {
+  char host[64];
+  uint16_t port;
+  BreakerState state;
+  uint8_t fails;
+  uint32_t probeMs;
+  uint32_t retryAt;
+  uint32_t trips;
+};
+
+Breaker breaker = {"", 0, BR_CLOSED, 0, 0, 0, 0};
+
+enum LatStage : uint8_t { LAT_DNS, LAT_CONNECT, LAT_TTFB, LAT_PARSE, LAT_FETCH, LAT_DRAW, LAT_COUNT };
+static const char* const LAT_NAMES[LAT_COUNT] = {"dns", "connect", "ttfb", "parse", "fetch", "draw"};
+static const uint8_t LAT_WINDOW = 32;
+
+struct LatRing {
+  uint32_t us[LAT_WINDOW];
+  uint8_t head;
+  uint8_t len;
+  uint32_t count;
+};
+
+struct LatSummary {
+  uint8_t n;
+  uint32_t min;
+  uint32_t avg;
+  uint32_t max;
+  uint32_t p95;
+};
+
+static LatRing lat[LAT_COUNT];
+
+static void latRecord(LatStage s, uint32_t us) {
+  LatRing& r = lat[s];
+  r.us[r.head] = us;
+  r.head = (r.head + 1) % LAT_WINDOW;
+  if (r.len < LAT_WINDOW) r.len++;
+  r.count++;
+}
+
+static LatSummary latSummary(LatStage s) {
+  const LatRing& r = lat[s];
+  LatSummary out = {r.len, 0, 0, 0, 0};
+  if (r.len == 0) return out;
+
+  uint32_t v[LAT_WINDOW];
+  uint64_t sum = 0;
+  for (uint8_t i = 0; i < r.len; i++) {
+    uint32_t x = r.us[i];
+    uint8_t j = i;
+    while (j > 0 && v[j - 1] > x) { v[j] = v[j - 1]; j--; }
+    v[j] = x;
+    sum += x;
+  }
+
+  out.min = v[0];
+  out.max = v[r.len - 1];
+  out.avg = (uint32_t)(sum / r.len);
+  out.p95 = v[(r.len * 95 + 99) / 100 - 1];
+  return out;
+}
+
+enum FetchErr : uint8_t {
+  FE_OK, FE_WIFI, FE_DNS, FE_CONNECT, FE_SEND, FE_TIMEOUT, FE_CLOSED,
+  FE_HTTP_4XX, FE_HTTP_5XX, FE_HTTP_OTHER, FE_PARSE, FE_NO_MEMORY, FE_COUNT
+};
+static const char* const FETCH_ERR_NAMES[FE_COUNT] = {
+  "ok", "wifi", "dns", "connect", "send", "timeout", "closed",
+  "http_4xx", "http_5xx", "http_other", "parse", "no_memory"
+};
+
+enum Endpoint : uint8_t { EP_PRICE, EP_PRICES, EP_KLINES, EP_WEBHOOK, EP_COUNT };
+static const char* const EP_NAMES[EP_COUNT] = {"price", "prices", "klines", "webhook"};
+
+static const uint8_t HIST_BUCKETS = 7;
+static const uint16_t HIST_BOUNDS_MS[HIST_BUCKETS - 1] = {50, 100, 250, 500, 1000, 2500};
+
+struct FetchResult {
+  FetchErr err;
+  int status;
+  DeserializationError::Code json;
+  uint32_t bytes;
+  uint32_t durationUs;
+  uint8_t retries;
+};
+
+struct EndpointStats {
+  uint32_t requests;
+  uint32_t errors[FE_COUNT];
+  uint32_t bytes;
+  uint32_t retries;
+  uint32_t sumMs;
+  uint32_t hist[HIST_BUCKETS];
+  FetchResult last;
+};
+
+static EndpointStats epStats[EP_COUNT];
+
+static void fetchRecord(Endpoint ep, const FetchResult& r) {
+  EndpointStats& e = epStats[ep];
+  uint32_t ms = r.durationUs / 1000;
+  uint8_t b = 0;
+  while (b < HIST_BUCKETS - 1 && ms > HIST_BOUNDS_MS[b]) b++;
+
+  e.requests++;
+  e.errors[r.err]++;
+  e.bytes += r.bytes;
+  e.retries += r.retries;
+  e.sumMs += ms;
+  e.hist[b]++;
+  e.last = r;
+}
+
+static const int DNS_CACHE_SLOTS = 4;
+static const uint32_t DNS_TTL_MS = 5UL * 60UL * 1000UL;
+static const uint32_t DNS_NEG_TTL_MS = 30000;
+static const uint32_t DNS_TIMEOUT_MS = 2000;
+
+struct DnsEntry {
+  char host[64];
+  IPAddress ip;
+  bool ok;
+  uint32_t at;
+};
+
+static DnsEntry dnsCache[DNS_CACHE_SLOTS];
+uint32_t dnsHits = 0;
+uint32_t dnsMisses = 0;
+uint32_t dnsFails = 0;
+
+enum NetPoll : uint8_t { NET_PENDING, NET_DONE, NET_FAILED };
+
+struct DnsLookup {
+  char host[64];
+  IPAddress ip;
+  bool busy;
+  volatile NetPoll result;
+  uint32_t at;
+  uint32_t startUs;
+};
+
+static DnsLookup dnsq;
+
+static void dnsFlush() {
+  for (int i = 0; i < DNS_CACHE_SLOTS; i++) dnsCache[i].host[0] = 0;
+  dnsq.busy = false;
+}
+
+static void dnsFound(const char* name, const ip_addr_t* addr, void*) {
+  if (!dnsq.busy || strcasecmp(name, dnsq.host) != 0) return;
+  if (addr) dnsq.ip = IPAddress(addr);
+  dnsq.result = addr ? NET_DONE : NET_FAILED;
+}
+
+static NetPoll dnsPoll(const char* host, IPAddress& ip) {
+  if (ip.fromString(host)) return NET_DONE;
+
+  uint32_t now = millis();
+  DnsEntry* e = &dnsCache[0];
+  for (int i = 0; i < DNS_CACHE_SLOTS; i++) {
+    DnsEntry& c = dnsCache[i];
+    if (c.host[0] && strcmp(c.host, host) == 0) {
+      if (now - c.at < (c.ok ? DNS_TTL_MS : DNS_NEG_TTL_MS)) {
+        dnsHits++;
+        ip = c.ip;
+        return c.ok ? NET_DONE : NET_FAILED;
+      }
+      e = &c;
+      break;
+    }
+    if (!c.host[0] || (e->host[0] && c.at < e->at)) e = &c;
+  }
+
+  if (!dnsq.busy || strcmp(dnsq.host, host) != 0) {
+    dnsMisses++;
+    strncpy(dnsq.host, host, sizeof(dnsq.host) - 1);
+    dnsq.host[sizeof(dnsq.host) - 1] = 0;
+    dnsq.busy = true;
+    dnsq.result = NET_PENDING;
+    dnsq.at = now;
+    dnsq.startUs = micros();
+    ip_addr_t addr;
+    err_t err = dns_gethostbyname(dnsq.host, &addr, dnsFound, nullptr);
+    if (err == ERR_OK) {
+      dnsq.ip = IPAddress(&addr);
+      dnsq.result = NET_DONE;
+    } else if (err != ERR_INPROGRESS) {
+      dnsq.result = NET_FAILED;
+    }
+  }
+  if (dnsq.result == NET_PENDING && now - dnsq.at < DNS_TIMEOUT_MS) return NET_PENDING;
+
+  dnsq.busy = false;
+  latRecord(LAT_DNS, micros() - dnsq.startUs);
+  bool ok = (dnsq.result == NET_DONE);
+  if (!ok) dnsFails++;
+  ip = dnsq.ip;
+
+  strncpy(e->host, host, sizeof(e->host) - 1);
+  e->host[sizeof(e->host) - 1] = 0;
+  e->ip = ip;
+  e->ok = ok;
+  e->at = now;
+  return ok ? NET_DONE : NET_FAILED;
+}
+
+// A TCP connect started with raw lwIP and polled from the loop. Once the
+// handshake completes the pcb is handed to a WiFiClient, which takes over
+// its callbacks.
+struct TcpDial {
+  tcp_pcb* pcb;
+  volatile err_t err;
+  uint32_t at;
+  uint32_t startUs;
+};
+
+class DialClient : public WiFiClient {
+ public:
+  explicit DialClient(tcp_pcb* pcb) : WiFiClient(new ClientContext(pcb, nullptr, nullptr)) {}
+};
+
+static err_t dialConnected(void* arg, tcp_pcb*, err_t err) {
+  ((TcpDial*)arg)->err = err;
+  return ERR_OK;
+}
+
+static void dialError(void* arg, err_t err) {
+  TcpDial* d = (TcpDial*)arg;
+  d->pcb = nullptr;
+  d->err = err;
+}
+
+static void dialAbort(TcpDial& d) {
+  if (!d.pcb) return;
+  tcp_arg(d.pcb, nullptr);
+  tcp_err(d.pcb, nullptr);
+  tcp_abort(d.pcb);
+  d.pcb = nullptr;
+}
+
+static bool dialStart(TcpDial& d, const IPAddress& ip, uint16_t port) {
+  dialAbort(d);
+  d.pcb = tcp_new();
+  if (!d.pcb) return false;
+  d.err = ERR_INPROGRESS;
+  d.at = millis();
+  d.startUs = micros();
+  tcp_arg(d.pcb, &d);
+  tcp_err(d.pcb, dialError);
+  if (tcp_connect(d.pcb, ip, port, dialConnected) == ERR_OK) return true;
+  dialAbort(d);
+  return false;
+}
+
+static NetPoll dialPoll(TcpDial& d, WiFiClient& client, uint32_t timeoutMs) {
+  if (d.pcb && d.err == ERR_INPROGRESS && millis() - d.at < timeoutMs) return NET_PENDING;
+  if (!d.pcb || d.err != ERR_OK) {
+    dialAbort(d);
+    return NET_FAILED;
+  }
+  tcp_err(d.pcb, nullptr);
+  client = DialClient(d.pcb);
+  d.pcb = nullptr;
+  return NET_DONE;
+}
+
+static Dec jsonDec(JsonVariantConst v) {
+  Dec d = 0;
+  const char* s = v.as<const char*>();
+  if (s) decParse(s, d);
+  else d = decFromDouble(v.as<double>());
+  return d;
+}
 
 enum Mode { MODE_SINGLE, MODE_TRIPLE, MODE_HOLDINGS };
 Mode currentMode = MODE_SINGLE;
 
 struct Coin {
   char symbol[12];
-  float price;
-  float lastPrice;
+  Dec price;
+  Dec lastPrice;
   uint8_t decimals;
 };
 
 struct Holding {
   char symbol[12];
-  float price;
-  float lastPrice;
-  float buyPrice;
-  float amount;
+  Dec price;
+  Dec lastPrice;
+  Dec buyPrice;
+  Dec amount;
   uint8_t decimals;
 };
 
@@ -52,14 +371,292 @@ Coin tripleCoins[3] = {
 };
 
 Holding holdings[3] = {
-  {"BTCUSDT", 0, -1, 50000.0, 0.1, 2},
-  {"ETHUSDT", 0, -1, 3000.0, 1.0, 2},
-  {"SOLUSDT", 0, -1, 100.0, 10.0, 2}
+  {"BTCUSDT", 0, -1, decFromDouble(50000.0), decFromDouble(0.1), 2},
+  {"ETHUSDT", 0, -1, decFromDouble(3000.0), decFromDouble(1.0), 2},
+  {"SOLUSDT", 0, -1, decFromDouble(100.0), decFromDouble(10.0), 2}
+};
+
+static const int PRICE_CACHE_SLOTS = 10;
+
+struct PriceEntry {
+  char symbol[12];
+  Dec price;
+  Dec lastPrice;
+  uint32_t at;
 };
 
+static PriceEntry priceCache[PRICE_CACHE_SLOTS];
+
+static PriceEntry* priceCacheFind(const char* sym) {
+  for (int i = 0; i < PRICE_CACHE_SLOTS; i++) {
+    if (priceCache[i].symbol[0] && strcmp(priceCache[i].symbol, sym) == 0) return &priceCache[i];
+  }
+  return nullptr;
+}
+
+static PriceEntry& priceCacheEntry(const char* sym) {
+  PriceEntry* e = priceCacheFind(sym);
+  if (e) return *e;
+
+  e = &priceCache[0];
+  for (int i = 1; i < PRICE_CACHE_SLOTS && e->symbol[0]; i++) {
+    if (!priceCache[i].symbol[0] || priceCache[i].at < e->at) e = &priceCache[i];
+  }
+  strncpy(e->symbol, sym, sizeof(e->symbol) - 1);
+  e->symbol[sizeof(e->symbol) - 1] = 0;
+  e->price = 0;
+  e->lastPrice = -1;
+  e->at = 0;
+  return *e;
+}
+
+static void priceCacheSync(const PriceEntry& e) {
+  auto sync = [&](char* sym, Dec& price, Dec& last) {
+    if (strcmp(sym, e.symbol) != 0) return;
+    price = e.price;
+    last = e.lastPrice;
+  };
+  sync(singleCoin.symbol, singleCoin.price, singleCoin.lastPrice);
+  for (int i = 0; i < 3; i++) {
+    sync(tripleCoins[i].symbol, tripleCoins[i].price, tripleCoins[i].lastPrice);
+    sync(holdings[i].symbol, holdings[i].price, holdings[i].lastPrice);
+  }
+}
+
 static const int KCOUNT = 10;
-float kO[KCOUNT], kH[KCOUNT], kL[KCOUNT], kC[KCOUNT];
-bool kReady = false;
+static const uint8_t KLINE_TAIL = 2;
+
+enum KInterval : uint8_t { KI_1M, KI_5M, KI_15M, KI_1H, KI_4H, KI_1D, KI_COUNT };
+static const char* const KI_NAMES[KI_COUNT] = {"1m", "5m", "15m", "1h", "4h", "1d"};
+static const uint32_t KI_SECONDS[KI_COUNT] = {60, 300, 900, 3600, 14400, 86400};
+
+struct KTier {
+  float o[KCOUNT], h[KCOUNT], l[KCOUNT], c[KCOUNT];
+  uint32_t t[KCOUNT];
+  uint32_t asOf;
+  uint8_t head;
+  uint8_t len;
+  bool ready;
+  bool stale;
+};
+
+KTier kTiers[KI_COUNT];
+KTier& kBase = kTiers[KI_1M];
+uint8_t kView = KI_1H;
+uint32_t kAt = 0;
+enum Widget : uint8_t { W_VIEW, W_COUNTDOWN, W_COUNT };
+
+struct FrameSched {
+  uint8_t dirty;
+  uint8_t urgent;
+  uint32_t dueAt[W_COUNT];
+  uint32_t lastAt;
+  uint32_t frames;
+  uint32_t coalesced;
+  uint32_t lastUs;
+  uint32_t maxUs;
+  uint32_t sumUs;
+  uint32_t windowAt;
+  uint32_t idleUs;
+  uint8_t idlePct;
+};
+
+FrameSched fs = {1 << W_VIEW | 1 << W_COUNTDOWN};
+
+static void frameInvalidate(Widget w, bool urgent = false) {
+  uint8_t bit = 1 << w;
+  if (fs.dirty & bit) fs.coalesced++;
+  fs.dirty |= bit;
+  if (urgent) fs.urgent |= bit;
+}
+
+static void klineChanged(const KTier& k) {
+  if (&k == &kTiers[kView]) frameInvalidate(W_VIEW);
+}
+
+static void setKReady(KTier& k, bool v) {
+  if (k.ready != v) klineChanged(k);
+  k.ready = v;
+}
+
+static int kIdx(const KTier& k, int i) {
+  return (k.head + i) % KCOUNT;
+}
+
+static uint32_t kNewest(const KTier& k) {
+  return k.len ? k.t[kIdx(k, k.len - 1)] : 0;
+}
+
+static void klineReset(KTier& k) {
+  k.head = 0;
+  k.len = 0;
+}
+
+static void klinePush(KTier& k, uint32_t t, float o, float h, float l, float c) {
+  int slot;
+  if (k.len < KCOUNT) {
+    slot = kIdx(k, k.len);
+    k.len++;
+  } else {
+    slot = k.head;
+    k.head = (k.head + 1) % KCOUNT;
+  }
+  k.t[slot] = t;
+  k.o[slot] = o;
+  k.h[slot] = h;
+  k.l[slot] = l;
+  k.c[slot] = c;
+  klineChanged(k);
+}
+
+static bool klineMerge(KTier& k, uint32_t sec, uint32_t t, float o, float h, float l, float c) {
+  if (k.len == 0) {
+    klinePush(k, t, o, h, l, c);
+    return true;
+  }
+
+  uint32_t newest = kNewest(k);
+  if (t == newest + sec) {
+    klinePush(k, t, o, h, l, c);
+    return true;
+  }
+  if (t > newest) return false;
+  if (t < k.t[k.head]) return true;
+
+  for (int i = k.len - 1; i >= 0; i--) {
+    int slot = kIdx(k, i);
+    if (k.t[slot] != t) continue;
+    if (k.o[slot] == o && k.h[slot] == h && k.l[slot] == l && k.c[slot] == c) return true;
+    k.o[slot] = o;
+    k.h[slot] = h;
+    k.l[slot] = l;
+    k.c[slot] = c;
+    klineChanged(k);
+    return true;
+  }
+  return false;
+}
+
+static void klineRoll(uint32_t t, float o, float h, float l, float c) {
+  for (uint8_t i = KI_1M + 1; i < KI_COUNT; i++) {
+    KTier& k = kTiers[i];
+    if (!k.ready || k.len == 0) continue;
+
+    uint32_t bucket = t - t % KI_SECONDS[i];
+    if (bucket > kNewest(k)) {
+      klinePush(k, bucket, o, h, l, c);
+      continue;
+    }
+    for (int j = k.len - 1; j >= 0; j--) {
+      int slot = kIdx(k, j);
+      if (k.t[slot] != bucket) continue;
+      if (h > k.h[slot]) k.h[slot] = h;
+      if (l < k.l[slot]) k.l[slot] = l;
+      if (j == k.len - 1) k.c[slot] = c;
+      klineChanged(k);
+      break;
+    }
+  }
+}
+
+static const uint32_t KLINE_CLOSE_DELAY_MS = 400;
+
+static time_t sntpTime() {
+  time_t t = time(nullptr);
+  return t >= NTP_VALID_AFTER ? t : 0;
+}
+
+static bool clockSynced() {
+  return timeStatus() != timeNotSet;
+}
+
+static void clockPoll() {
+  if (clockSettled || timeStatus() != timeSet) return;
+  setSyncInterval(NTP_SYNC_S);
+  clockSettled = true;
+}
+
+static uint64_t wallMs() {
+  timeval tv;
+  gettimeofday(&tv, nullptr);
+  return (uint64_t)tv.tv_sec * 1000ULL + (uint64_t)(tv.tv_usec / 1000);
+}
+
+static uint32_t klineAsOf() {
+  return clockSynced() ? (uint32_t)now() : 0;
+}
+
+static void klineTick(Dec p) {
+  float c = (float)((double)p / (double)DEC_SCALE);
+  for (uint8_t i = 0; i < KI_COUNT; i++) {
+    KTier& k = kTiers[i];
+    if (!k.ready || k.len == 0) continue;
+    int slot = kIdx(k, k.len - 1);
+    if (clockSynced() && (uint32_t)now() >= k.t[slot] + KI_SECONDS[i]) continue;
+
+    k.c[slot] = c;
+    if (c > k.h[slot]) k.h[slot] = c;
+    if (c < k.l[slot]) k.l[slot] = c;
+  }
+}
+
+static const int KLINE_CACHE_SLOTS = 3;
+static const uint32_t KLINE_CACHE_TTL_MS = 3600UL * 1000UL;
+
+struct KlineStash {
+  char symbol[12];
+  uint32_t at;
+  KTier tiers[KI_COUNT];
+};
+
+static KlineStash klineCache[KLINE_CACHE_SLOTS];
+
+static bool stashUsable(const KlineStash& s) {
+  for (uint8_t i = 0; i < KI_COUNT; i++) {
+    if (s.tiers[i].ready) return true;
+  }
+  return false;
+}
+
+static KlineStash* klineStashFind(const char* sym) {
+  for (int i = 0; i < KLINE_CACHE_SLOTS; i++) {
+    if (stashUsable(klineCache[i]) && strcmp(klineCache[i].symbol, sym) == 0) return &klineCache[i];
+  }
+  return nullptr;
+}
+
+static KlineStash* klineStashSlot(const char* sym) {
+  KlineStash* s = &klineCache[0];
+  for (int i = 0; i < KLINE_CACHE_SLOTS; i++) {
+    if (strcmp(klineCache[i].symbol, sym) == 0) return &klineCache[i];
+    if (klineCache[i].at < s->at) s = &klineCache[i];
+  }
+
+  memset(s, 0, sizeof(*s));
+  strncpy(s->symbol, sym, sizeof(s->symbol) - 1);
+  return s;
+}
+
+static void klineStash(const char* sym) {
+  bool any = false;
+  for (uint8_t i = 0; i < KI_COUNT; i++) any = any || kTiers[i].ready;
+  if (!any) return;
+
+  KlineStash* s = klineStashSlot(sym);
+  s->at = kAt;
+  memcpy(s->tiers, kTiers, sizeof(kTiers));
+}
+
+static void klineRestore(const char* sym) {
+  memset(kTiers, 0, sizeof(kTiers));
+  frameInvalidate(W_VIEW);
+
+  KlineStash* s = klineStashFind(sym);
+  if (!s || millis() - s->at >= KLINE_CACHE_TTL_MS) return;
+
+  memcpy(kTiers, s->tiers, sizeof(kTiers));
+  kAt = s->at;
+}
 
 static const int TITLE_Y = 4;
 static const int DIV1_Y  = 22;
@@ -67,11 +664,24 @@ static const int PRICE_Y = 26;
 static const int DIV2_Y  = 56;
 static const int CHART_TOP = 62;
 static const int CHART_BOTTOM = 235;
+static const int HOUR_LABEL_H = 10;
+
+enum WireFormat : uint8_t { WIRE_JSON = 0, WIRE_MSGPACK = 1 };
 
 struct AppConfig {
   uint32_t magic;
   char apiBase[96];
   char webhook[192];
+  uint8_t wire;
+  uint16_t priceSec;
+  uint16_t klineSec;
+  uint16_t fastSec;
+  uint8_t stream;
+  char rotation[64];
+  uint16_t prefetchReq;
+  uint16_t prefetchKB;
+  uint8_t interval;
+  int16_t tzMin;
 };
 
 static const uint32_t CFG_MAGIC = 0xC0A11CE6;
@@ -82,6 +692,53 @@ static void cfgDefaults() {
   cfg.magic = CFG_MAGIC;
   strncpy(cfg.apiBase, "http://YOUR_API_HOST:8000", sizeof(cfg.apiBase) - 1);
   strncpy(cfg.webhook, "", sizeof(cfg.webhook) - 1);
+  cfg.wire = WIRE_JSON;
+  cfg.priceSec = 15;
+  cfg.klineSec = 60;
+  cfg.fastSec = 5;
+  cfg.stream = 0;
+  strncpy(cfg.rotation, "BTCUSDT,ETHUSDT,SOLUSDT", sizeof(cfg.rotation) - 1);
+  cfg.prefetchReq = 120;
+  cfg.prefetchKB = 256;
+  cfg.interval = KI_1H;
+  cfg.tzMin = TZ_DEFAULT_MIN;
+}
+
+static void cfgSanitize() {
+  if (cfg.wire != WIRE_MSGPACK) cfg.wire = WIRE_JSON;
+  if (cfg.stream != 1) cfg.stream = 0;
+  if (cfg.priceSec < 3 || cfg.priceSec > 3600) cfg.priceSec = 15;
+  if (cfg.klineSec < 10 || cfg.klineSec > 3600) cfg.klineSec = 60;
+  if (cfg.fastSec < 2 || cfg.fastSec > cfg.priceSec) cfg.fastSec = (cfg.priceSec < 5) ? cfg.priceSec : 5;
+  cfg.rotation[sizeof(cfg.rotation) - 1] = 0;
+  for (char* c = cfg.rotation; *c; c++) {
+    if (!isupper((unsigned char)*c) && !isdigit((unsigned char)*c) && *c != ',') { cfg.rotation[0] = 0; break; }
+  }
+  if (cfg.prefetchReq > 3600) cfg.prefetchReq = 120;
+  if (cfg.prefetchKB > 4096) cfg.prefetchKB = 256;
+  if (cfg.interval >= KI_COUNT) cfg.interval = KI_1H;
+  if (cfg.tzMin < -720 || cfg.tzMin > 840 || cfg.tzMin % 15) cfg.tzMin = TZ_DEFAULT_MIN;
+}
+
+static bool rotationNext(const char* cur, char* out, size_t len) {
+  const char* first = nullptr;
+  bool take = false;
+  for (const char* p = cfg.rotation; *p; ) {
+    const char* e = strchr(p, ',');
+    size_t n = e ? (size_t)(e - p) : strlen(p);
+    bool isCur = (n == strlen(cur) && strncmp(p, cur, n) == 0);
+    if (n > 0 && n < len && !isCur) {
+      if (take || !first) {
+        memcpy(out, p, n);
+        out[n] = 0;
+        if (take) return true;
+        first = p;
+      }
+    }
+    if (isCur) take = true;
+    p = e ? e + 1 : p + n;
+  }
+  return first != nullptr;
 }
 
 static void cfgLoad() {
@@ -92,6 +749,7 @@ static void cfgLoad() {
     EEPROM.put(0, cfg);
     EEPROM.commit();
   }
+  cfgSanitize();
 }
 
 static void cfgSave() {
@@ -100,287 +758,2460 @@ static void cfgSave() {
   EEPROM.commit();
 }
 
-static void formatPrice(char* out, size_t len, float v, uint8_t d) {
-  if (d > 6) d = 6;
-  char fmt[12];
-  snprintf(fmt, sizeof(fmt), "$%%.%df", d);
-  snprintf(out, len, fmt, v);
+static const uint32_t SPI_WINDOW_BYTES = 11;
+
+uint32_t spiBytes = 0;
+uint32_t spiWindows = 0;
+uint32_t spiFrameBytes = 0;
+uint32_t spiLastFrameBytes = 0;
+uint32_t spiFramesBytes = 0;
+uint32_t framesFull = 0;
+uint32_t framesPartial = 0;
+
+static void spiCount(int w, int h) {
+  if (w <= 0 || h <= 0) return;
+  uint32_t n = SPI_WINDOW_BYTES + (uint32_t)w * (uint32_t)h * 2;
+  spiBytes += n;
+  spiFrameBytes += n;
+  spiWindows++;
 }
 
-static void formatPL(char* out, size_t len, float v) {
-  if (v >= 0) snprintf(out, len, "+$%.2f", v);
-  else snprintf(out, len, "-$%.2f", -v);
+static void lcdFill(int x, int y, int w, int h, uint16_t col) {
+  if (w <= 0 || h <= 0) return;
+  tft.fillRect(x, y, w, h, col);
+  spiCount(w, h);
 }
 
-static void formatPercent(char* out, size_t len, float pct) {
-  if (pct >= 0) snprintf(out, len, "+%.2f%%", pct);
-  else snprintf(out, len, "%.2f%%", pct);
+static void lcdVLine(int x, int y, int h, uint16_t col) {
+  if (h <= 0) return;
+  tft.drawFastVLine(x, y, h, col);
+  spiCount(1, h);
 }
 
-static void drawDivider(int y) {
-  tft.drawFastHLine(0, y, TFT_W, TFT_DARKGREY);
+static uint16_t lcdText(int x, int y, uint8_t font, uint16_t col, const char* s) {
+  tft.setTextFont(font);
+  tft.setTextColor(col, TFT_BLACK);
+  tft.setCursor(x, y);
+  tft.print(s);
+  uint16_t w = tft.textWidth(s);
+  spiCount(w, tft.fontHeight(font));
+  return w;
 }
 
-static void drawCountdown(uint32_t now) {
-  uint32_t remain = (REFRESH_MS - (now - lastFetch)) / 1000;
-  if ((int32_t)remain < 0) remain = 0;
-  if (remain > 99) remain = 99;
+#ifndef SPRITE_POOL_BYTES
+#define SPRITE_POOL_BYTES 10240
+#endif
 
-  tft.fillRect(170, 0, 70, 18, TFT_BLACK);
-  tft.setTextFont(2);
-  tft.setTextColor(TFT_CYAN, TFT_BLACK);
-  tft.setCursor(178, 2);
-  tft.printf("T-%us", (unsigned int)remain);
-}
+static const int PANEL_MAX_H = 80;
 
-static void normalizeSymbol(String &s) {
-  s.trim();
-  s.toUpperCase();
-  if (!s.endsWith("USDT")) s += "USDT";
-  if (s.length() > 11) s = s.substring(0, 11);
+static const uint16_t PANEL_PALETTE[16] = {
+  TFT_BLACK, TFT_WHITE, TFT_GREEN, TFT_RED, TFT_CYAN, TFT_DARKGREY, TFT_LIGHTGREY, TFT_ORANGE,
+  TFT_YELLOW, TFT_BLUE, TFT_MAGENTA, TFT_NAVY, TFT_DARKGREEN, TFT_MAROON, TFT_PURPLE, TFT_OLIVE
+};
+
+TFT_eSprite spr = TFT_eSprite(&tft);
+
+struct SpritePool {
+  uint16_t rows;
+  uint32_t bytes;
+  uint32_t pushes;
+  uint32_t direct;
+};
+
+SpritePool pool;
+
+static void spritePoolInit() {
+  uint32_t rows = (uint32_t)SPRITE_POOL_BYTES * 2 / TFT_W;
+  if (rows > PANEL_MAX_H) rows = PANEL_MAX_H;
+  pool.rows = 0;
+  pool.bytes = 0;
+  if (rows == 0) return;
+
+  spr.setColorDepth(4);
+  if (!spr.createSprite(TFT_W, rows)) return;
+  spr.createPalette(PANEL_PALETTE);
+  pool.rows = rows;
+  pool.bytes = TFT_W * rows / 2;
 }
 
-static void setCoinSymbol(Coin &c, const String &sym) {
-  String s = sym;
-  normalizeSymbol(s);
-  s.toCharArray(c.symbol, sizeof(c.symbol));
-  c.lastPrice = -1;
+static uint16_t paletteIndex(uint16_t col) {
+  for (uint8_t i = 0; i < 16; i++) {
+    if (PANEL_PALETTE[i] == col) return i;
+  }
+  return 1;
 }
 
-static void setHoldingSymbol(Holding &h, const String &sym) {
-  String s = sym;
-  normalizeSymbol(s);
-  s.toCharArray(h.symbol, sizeof(h.symbol));
-  h.lastPrice = -1;
+#ifndef GLYPH_ATLAS_BYTES
+#define GLYPH_ATLAS_BYTES 4096
+#endif
+
+static const char ATLAS_CHARS[] = "0123456789$+-.,%";
+static const uint8_t ATLAS_FONTS[] = {4, 2};
+static const int ATLAS_GLYPHS = sizeof(ATLAS_CHARS) - 1;
+static const int ATLAS_MAX_W = 32;
+static const int ATLAS_BENCH_ROUNDS = 4;
+
+struct Glyph {
+  uint16_t off;
+  uint8_t w;
+};
+
+struct GlyphAtlas {
+  Glyph glyphs[sizeof(ATLAS_FONTS)][ATLAS_GLYPHS];
+  uint16_t used;
+  uint32_t drawCharNs;
+  uint32_t pushNs;
+  uint32_t blitNs;
+  uint32_t blits;
+  uint32_t misses;
+};
+
+GlyphAtlas atlas;
+uint8_t atlasBuf[GLYPH_ATLAS_BYTES];
+
+static const Glyph* glyphFind(char ch, uint8_t font) {
+  const char* p = strchr(ATLAS_CHARS, ch);
+  if (!ch || !p) return nullptr;
+  for (uint8_t f = 0; f < sizeof(ATLAS_FONTS); f++) {
+    const Glyph& g = atlas.glyphs[f][p - ATLAS_CHARS];
+    if (ATLAS_FONTS[f] == font) return g.w ? &g : nullptr;
+  }
+  return nullptr;
 }
 
-static String formatUptime(uint32_t ms) {
-  uint32_t s = ms / 1000UL;
-  uint32_t m = s / 60UL; s %= 60UL;
-  uint32_t h = m / 60UL; m %= 60UL;
-  uint32_t d = h / 24UL; h %= 24UL;
-  String out;
-  if (d) out += String(d) + "d ";
-  char buf[16];
-  snprintf(buf, sizeof(buf), "%02lu:%02lu:%02lu",
-           (unsigned long)h, (unsigned long)m, (unsigned long)s);
-  out += buf;
-  return out;
+static void glyphBlit(uint8_t* img, int stride, int clipW, int clipH, const Glyph& g, int gh, int x, int y, uint8_t fg, uint8_t bg) {
+  int rowBytes = (g.w + 1) / 2;
+  bool aligned = !(x & 1) && x >= 0 && x + g.w <= clipW;
+  for (int r = 0; r < gh; r++) {
+    if (y + r < 0 || y + r >= clipH) continue;
+    const uint8_t* src = atlasBuf + g.off + r * rowBytes;
+    uint8_t* row = img + (y + r) * stride;
+
+    if (aligned) {
+      uint8_t* d = row + (x >> 1);
+      for (int k = 0; k < rowBytes; k++) {
+        uint8_t v = ((src[k] & 0xF0) ? fg : bg) << 4;
+        if (2 * k + 1 < g.w) v |= (src[k] & 0x0F) ? fg : bg;
+        else v |= d[k] & 0x0F;
+        d[k] = v;
+      }
+      continue;
+    }
+
+    for (int c = 0; c < g.w; c++) {
+      int px = x + c;
+      if (px < 0 || px >= clipW) continue;
+      uint8_t on = (c & 1) ? (src[c >> 1] & 0x0F) : (src[c >> 1] & 0xF0);
+      uint8_t v = on ? fg : bg;
+      uint8_t& d = row[px >> 1];
+      d = (px & 1) ? (d & 0xF0) | v : (d & 0x0F) | (v << 4);
+    }
+  }
 }
 
-static String buildSysReportText() {
-  String ip = WiFi.isConnected() ? WiFi.localIP().toString() : String("N/A");
-  long rssi = WiFi.isConnected() ? WiFi.RSSI() : 0;
+static void atlasBuild() {
+  memset(&atlas, 0, sizeof(atlas));
+
+  TFT_eSprite tmp = TFT_eSprite(&tft);
+  tmp.setColorDepth(4);
+  if (!tmp.createSprite(ATLAS_MAX_W, tft.fontHeight(4))) return;
+  uint8_t* img = (uint8_t*)tmp.getPointer();
+  int stride = ATLAS_MAX_W / 2;
+  tmp.setTextColor(1, 0);
+
+  for (uint8_t f = 0; f < sizeof(ATLAS_FONTS); f++) {
+    uint8_t font = ATLAS_FONTS[f];
+    int gh = tft.fontHeight(font);
+    for (int i = 0; i < ATLAS_GLYPHS; i++) {
+      char b[2] = {ATLAS_CHARS[i], 0};
+      int w = tft.textWidth(b, font);
+      int rowBytes = (w + 1) / 2;
+      if (w <= 0 || w > ATLAS_MAX_W || gh > tft.fontHeight(4)) continue;
+      if (atlas.used + rowBytes * gh > GLYPH_ATLAS_BYTES) continue;
+
+      tmp.fillSprite(0);
+      tmp.drawChar(b[0], 0, 0, font);
+      for (int r = 0; r < gh; r++) memcpy(atlasBuf + atlas.used + r * rowBytes, img + r * stride, rowBytes);
+      atlas.glyphs[f][i].off = atlas.used;
+      atlas.glyphs[f][i].w = w;
+      atlas.used += rowBytes * gh;
+    }
+  }
 
-  uint32_t heap = ESP.getFreeHeap();
-  uint32_t flash = ESP.getFlashChipSize();
-  uint32_t sketch = ESP.getSketchSize();
-  uint32_t freeSketch = ESP.getFreeSketchSpace();
+  tmp.deleteSprite();
 
-  String msg;
-  msg.reserve(256);
-  msg += "ESP8266 status\n";
-  msg += "• Uptime: " + formatUptime(millis()) + "\n";
-  msg += "• FreeHeap: " + String(heap) + " B\n";
+  const Glyph* digits[10];
+  for (uint8_t i = 0; i < 10; i++) {
+    digits[i] = glyphFind('0' + i, 4);
+    if (!digits[i]) return;
+  }
 
-  #if defined(ARDUINO_ESP8266_MAJOR)
-    msg += "• HeapFrag: " + String(ESP.getHeapFragmentation()) + " %\n";
-    msg += "• MaxFreeBlock: " + String(ESP.getMaxFreeBlockSize()) + " B\n";
-  #endif
+  const int n = ATLAS_BENCH_ROUNDS * 10;
+  int gh = tft.fontHeight(4);
+  uint16_t cmap[16];
+  for (uint8_t k = 0; k < 16; k++) cmap[k] = k ? TFT_WHITE : TFT_BLACK;
 
-  msg += "• Flash: " + String(flash) + " B\n";
-  msg += "• Sketch: " + String(sketch) + " B\n";
-  msg += "• FreeSketch: " + String(freeSketch) + " B\n";
-  msg += "• WiFi: " + String(WiFi.SSID()) + "  RSSI " + String(rssi) + " dBm\n";
-  msg += "• IP: " + ip + "\n";
-  msg += "• ChipID: " + String(ESP.getChipId()) + "\n";
-  return msg;
+  tft.setTextColor(TFT_WHITE, TFT_BLACK);
+  uint32_t t = micros();
+  for (int k = 0; k < ATLAS_BENCH_ROUNDS; k++) {
+    for (uint8_t i = 0; i < 10; i++) tft.drawChar('0' + i, 0, 0, 4);
+  }
+  atlas.drawCharNs = (micros() - t) * 1000 / n;
+
+  t = micros();
+  for (int k = 0; k < ATLAS_BENCH_ROUNDS; k++) {
+    for (uint8_t i = 0; i < 10; i++) tft.pushImage(0, 0, digits[i]->w, gh, atlasBuf + digits[i]->off, false, cmap);
+  }
+  atlas.pushNs = (micros() - t) * 1000 / n;
+  tft.fillRect(0, 0, ATLAS_MAX_W, gh, TFT_BLACK);
+
+  if (!pool.rows) return;
+  uint8_t* sprImg = (uint8_t*)spr.getPointer();
+  t = micros();
+  for (int k = 0; k < ATLAS_BENCH_ROUNDS; k++) {
+    for (uint8_t i = 0; i < 10; i++) glyphBlit(sprImg, TFT_W / 2, TFT_W, pool.rows, *digits[i], gh, 0, 0, 1, 0);
+  }
+  atlas.blitNs = (micros() - t) * 1000 / n;
 }
 
-static bool postFeishuText(const String& text, String* outResp = nullptr, int* outCode = nullptr) {
-  String hook = String(cfg.webhook);
-  hook.trim();
+struct TextCell {
+  char s[32];
+  uint16_t col;
+  int16_t x;
+  int16_t y;
+  uint16_t w;
+  uint8_t font;
+};
 
-  if (hook.length() == 0) {
-    if (outResp) *outResp = "webhook not set";
-    if (outCode) *outCode = -3;
-    return false;
-  }
+struct Panel {
+  int16_t x;
+  int16_t y;
+  int16_t w;
+  int16_t h;
+  int16_t divY;
+  uint8_t count;
+  TextCell* cells[6];
+  int16_t dx0;
+  int16_t dy0;
+  int16_t dx1;
+  int16_t dy1;
+};
+
+struct CandleSlot {
+  int16_t wickY;
+  int16_t wickH;
+  int16_t bodyY;
+  int16_t bodyH;
+  uint16_t col;
+};
+
+struct RowView {
+  TextCell symbol;
+  TextCell price;
+  TextCell pl;
+  TextCell info;
+  TextCell pct;
+  Panel panel;
+};
+
+struct ViewModel {
+  bool valid;
+  Mode mode;
+  TextCell countdown;
+  TextCell symbol;
+  TextCell interval;
+  TextCell price;
+  TextCell note;
+  Panel header;
+  Panel strip;
+  Panel notePanel;
+  Panel* top;
+  bool chart;
+  CandleSlot slots[KCOUNT];
+  char labels[KCOUNT * 6 + 1];
+  RowView rows[3];
+};
+
+ViewModel vm;
+
+static void panelInit(Panel& p, int x, int y, int w, int h, int divY) {
+  p.x = x;
+  p.y = y;
+  p.w = w;
+  p.h = h;
+  p.divY = divY;
+  p.count = 0;
+  p.dx1 = p.dx0 = 0;
+}
+
+static void panelAdd(Panel& p, TextCell& c) {
+  if (p.count < sizeof(p.cells) / sizeof(p.cells[0])) p.cells[p.count++] = &c;
+}
+
+static void panelDirty(Panel& p, int x, int y, int w, int h) {
+  if (w <= 0 || h <= 0) return;
+  if (p.dx1 <= p.dx0) {
+    p.dx0 = x;
+    p.dy0 = y;
+    p.dx1 = x + w;
+    p.dy1 = y + h;
+    return;
+  }
+  p.dx0 = min((int)p.dx0, x);
+  p.dy0 = min((int)p.dy0, y);
+  p.dx1 = max((int)p.dx1, x + w);
+  p.dy1 = max((int)p.dy1, y + h);
+}
+
+static int glyphW(char ch, uint8_t font) {
+  char b[2] = {ch, 0};
+  return tft.textWidth(b, font);
+}
+
+static void cellDiff(Panel& p, const TextCell& c, int x, int y, uint8_t font, uint16_t col, const char* s, uint16_t w) {
+  if (!c.w || c.font != font || c.y != y || c.col != col) {
+    if (c.w) panelDirty(p, c.x, c.y, c.w, tft.fontHeight(c.font));
+    panelDirty(p, x, y, w, tft.fontHeight(font));
+    return;
+  }
+
+  int lo = INT16_MAX, hi = INT16_MIN;
+  auto mark = [&](int gx, int gw) {
+    lo = min(lo, gx);
+    hi = max(hi, gx + gw);
+  };
+
+  const char* a = c.s;
+  const char* b = s;
+  int ax = c.x, bx = x;
+  while (*a || *b) {
+    if (*a && (!*b || ax < bx)) {
+      int gw = glyphW(*a++, font);
+      mark(ax, gw);
+      ax += gw;
+    } else if (*b && (!*a || bx < ax)) {
+      int gw = glyphW(*b++, font);
+      mark(bx, gw);
+      bx += gw;
+    } else {
+      int aw = glyphW(*a, font), bw = glyphW(*b, font);
+      if (*a != *b) {
+        mark(ax, aw);
+        mark(bx, bw);
+      }
+      ax += aw;
+      bx += bw;
+      a++;
+      b++;
+    }
+  }
+  if (hi > lo) panelDirty(p, lo, y, hi - lo, tft.fontHeight(font));
+}
+
+static bool cellSet(Panel& p, TextCell& c, int x, int y, uint8_t font, uint16_t col, const char* s, bool alignRight = false) {
+  tft.setTextFont(font);
+  uint16_t w = tft.textWidth(s);
+  if (alignRight) x -= w;
+  if (c.font == font && c.x == x && c.y == y && c.col == col && strcmp(c.s, s) == 0) return false;
+
+  cellDiff(p, c, x, y, font, col, s, w);
+  strncpy(c.s, s, sizeof(c.s) - 1);
+  c.col = col;
+  c.x = x;
+  c.y = y;
+  c.w = w;
+  c.font = font;
+  return true;
+}
+
+static void panelRender(TFT_eSPI& g, const Panel& p, int x0, int y0, int w, int h, int ox, int oy, bool indexed) {
+  uint16_t bg = indexed ? paletteIndex(TFT_BLACK) : TFT_BLACK;
+  for (uint8_t i = 0; i < p.count; i++) {
+    const TextCell& c = *p.cells[i];
+    int ch = tft.fontHeight(c.font);
+    if (!c.w || c.x >= x0 + w || c.x + c.w <= x0 || c.y >= y0 + h || c.y + ch <= y0) continue;
+    uint16_t fg = indexed ? paletteIndex(c.col) : c.col;
+    uint16_t cmap[16];
+    for (uint8_t k = 0; k < 16 && !indexed; k++) cmap[k] = k ? c.col : TFT_BLACK;
+    g.setTextColor(fg, bg);
+    int gx = c.x;
+    for (const char* q = c.s; *q; q++) {
+      int gw = glyphW(*q, c.font);
+      if (gx < x0 + w && gx + gw > x0) {
+        const Glyph* gl = glyphFind(*q, c.font);
+        if (gl && indexed) glyphBlit((uint8_t*)spr.getPointer(), TFT_W / 2, w, h, *gl, ch, gx - ox, c.y - oy, fg, bg);
+        else if (gl) tft.pushImage(gx, c.y, gl->w, ch, atlasBuf + gl->off, false, cmap);
+        else g.drawChar(*q, gx - ox, c.y - oy, c.font);
+        if (gl) atlas.blits++;
+        else atlas.misses++;
+        if (!indexed) spiCount(gw, ch);
+      }
+      gx += gw;
+    }
+  }
+  if (p.divY >= y0 && p.divY < y0 + h) {
+    g.drawFastHLine(x0 - ox, p.divY - oy, w, indexed ? paletteIndex(TFT_DARKGREY) : TFT_DARKGREY);
+    if (!indexed) spiCount(w, 1);
+  }
+}
+
+static void panelFlush(Panel& p) {
+  int x0 = max((int)p.dx0, (int)p.x);
+  int y0 = max((int)p.dy0, (int)p.y);
+  int x1 = min((int)p.dx1, p.x + p.w);
+  int y1 = min((int)p.dy1, p.y + p.h);
+  p.dx1 = p.dx0 = 0;
+  if (x1 <= x0 || y1 <= y0) return;
+
+  int w = x1 - x0;
+  if (!pool.rows) {
+    lcdFill(x0, y0, w, y1 - y0, TFT_BLACK);
+    panelRender(tft, p, x0, y0, w, y1 - y0, 0, 0, false);
+    pool.direct++;
+    return;
+  }
+
+  uint8_t* img = (uint8_t*)spr.getPointer();
+  int stride = (w + 1) / 2;
+  for (int y = y0; y < y1; y += pool.rows) {
+    int h = min((int)pool.rows, y1 - y);
+    spr.fillRect(0, 0, w, h, paletteIndex(TFT_BLACK));
+    panelRender(spr, p, x0, y, w, h, x0, y, true);
+    for (int r = 1; r < h && stride < TFT_W / 2; r++) memmove(img + r * stride, img + r * (TFT_W / 2), stride);
+    tft.pushImage(x0, y, w, h, img, false, (uint16_t*)PANEL_PALETTE);
+    spiCount(w, h);
+    pool.pushes++;
+  }
+}
+
+static void viewLayout() {
+  if (currentMode == MODE_SINGLE) {
+    panelInit(vm.header, 0, 0, TFT_W, DIV1_Y + 1, DIV1_Y);
+    panelAdd(vm.header, vm.symbol);
+    panelAdd(vm.header, vm.interval);
+    panelAdd(vm.header, vm.countdown);
+    panelInit(vm.strip, 0, DIV1_Y + 1, TFT_W, DIV2_Y - DIV1_Y, DIV2_Y);
+    panelAdd(vm.strip, vm.price);
+    panelInit(vm.notePanel, 0, CHART_TOP, TFT_W, CHART_BOTTOM - CHART_TOP, -1);
+    panelAdd(vm.notePanel, vm.note);
+    vm.top = &vm.header;
+    return;
+  }
+
+  for (int i = 0; i < 3; i++) {
+    RowView& r = vm.rows[i];
+    int y = i * 80;
+    panelInit(r.panel, 0, y, TFT_W, 80, y + (currentMode == MODE_TRIPLE ? 22 : 18));
+    panelAdd(r.panel, r.symbol);
+    panelAdd(r.panel, r.price);
+    panelAdd(r.panel, r.pl);
+    panelAdd(r.panel, r.info);
+    panelAdd(r.panel, r.pct);
+  }
+  panelAdd(vm.rows[0].panel, vm.countdown);
+  vm.top = &vm.rows[0].panel;
+}
+
+static bool viewBegin() {
+  spiFrameBytes = 0;
+  if (vm.valid && vm.mode == currentMode) return false;
+
+  memset(&vm, 0, sizeof(vm));
+  vm.valid = true;
+  vm.mode = currentMode;
+  viewLayout();
+  lcdFill(0, 0, TFT_W, TFT_H, TFT_BLACK);
+  return true;
+}
+
+static void viewEnd(bool full) {
+  if (full) framesFull++;
+  else framesPartial++;
+  spiLastFrameBytes = spiFrameBytes;
+  spiFramesBytes += spiFrameBytes;
+}
+
+static void drawCountdown(uint32_t remainMs) {
+  if (!vm.valid) return;
+  uint32_t remain = remainMs / 1000;
+  if (remain > 99) remain = 99;
+  bool down = (breaker.state != BR_CLOSED);
+
+  char buf[12];
+  snprintf(buf, sizeof(buf), down ? "API %us" : "T-%us", (unsigned int)remain);
+  if (cellSet(*vm.top, vm.countdown, down ? 172 : 178, 2, 2, down ? TFT_RED : TFT_CYAN, buf)) panelFlush(*vm.top);
+}
+
+static void normalizeSymbol(String &s) {
+  s.trim();
+  s.toUpperCase();
+  if (!s.endsWith("USDT")) s += "USDT";
+  if (s.length() > 11) s = s.substring(0, 11);
+}
+
+static void setCoinSymbol(Coin &c, const String &sym) {
+  String s = sym;
+  normalizeSymbol(s);
+  s.toCharArray(c.symbol, sizeof(c.symbol));
+  PriceEntry* e = priceCacheFind(c.symbol);
+  c.price = e ? e->price : 0;
+  c.lastPrice = e ? e->lastPrice : -1;
+}
+
+static void setHoldingSymbol(Holding &h, const String &sym) {
+  String s = sym;
+  normalizeSymbol(s);
+  s.toCharArray(h.symbol, sizeof(h.symbol));
+  PriceEntry* e = priceCacheFind(h.symbol);
+  h.price = e ? e->price : 0;
+  h.lastPrice = e ? e->lastPrice : -1;
+}
+
+static String formatUptime(uint32_t ms) {
+  uint32_t s = ms / 1000UL;
+  uint32_t m = s / 60UL; s %= 60UL;
+  uint32_t h = m / 60UL; m %= 60UL;
+  uint32_t d = h / 24UL; h %= 24UL;
+  String out;
+  if (d) out += String(d) + "d ";
+  char buf[16];
+  snprintf(buf, sizeof(buf), "%02lu:%02lu:%02lu",
+           (unsigned long)h, (unsigned long)m, (unsigned long)s);
+  out += buf;
+  return out;
+}
+
+static String buildSysReportText() {
+  String ip = WiFi.isConnected() ? WiFi.localIP().toString() : String("N/A");
+  long rssi = WiFi.isConnected() ? WiFi.RSSI() : 0;
+
+  uint32_t heap = ESP.getFreeHeap();
+  uint32_t flash = ESP.getFlashChipSize();
+  uint32_t sketch = ESP.getSketchSize();
+  uint32_t freeSketch = ESP.getFreeSketchSpace();
+
+  String msg;
+  msg.reserve(256);
+  msg += "ESP8266 status\n";
+  msg += "• Uptime: " + formatUptime(millis()) + "\n";
+  msg += "• FreeHeap: " + String(heap) + " B\n";
+
+  #if defined(ARDUINO_ESP8266_MAJOR)
+    msg += "• HeapFrag: " + String(ESP.getHeapFragmentation()) + " %\n";
+    msg += "• MaxFreeBlock: " + String(ESP.getMaxFreeBlockSize()) + " B\n";
+  #endif
+
+  msg += "• Flash: " + String(flash) + " B\n";
+  msg += "• Sketch: " + String(sketch) + " B\n";
+  msg += "• FreeSketch: " + String(freeSketch) + " B\n";
+  msg += "• WiFi: " + String(WiFi.SSID()) + "  RSSI " + String(rssi) + " dBm\n";
+  msg += "• IP: " + ip + "\n";
+  msg += "• ChipID: " + String(ESP.getChipId()) + "\n";
+  return msg;
+}
+
+static void heapMark() {
+  uint32_t h = ESP.getFreeHeap();
+  if (h < heapLow) heapLow = h;
+  #if defined(ARDUINO_ESP8266_MAJOR)
+    uint32_t b = ESP.getMaxFreeBlockSize();
+    if (b < blockLow) blockLow = b;
+  #endif
+}
+
+static bool postFeishuText(const String& text, String* outResp = nullptr, int* outCode = nullptr) {
+  uint32_t start = micros();
+  FetchResult r = {FE_OK, 0, DeserializationError::Ok, 0, 0, 0};
+  auto record = [&](FetchErr err) {
+    r.err = err;
+    r.durationUs = micros() - start;
+    fetchRecord(EP_WEBHOOK, r);
+  };
+
+  String hook = String(cfg.webhook);
+  hook.trim();
+
+  if (hook.length() == 0) {
+    if (outResp) *outResp = "webhook not set";
+    if (outCode) *outCode = -3;
+    return false;
+  }
+
+  if (!WiFi.isConnected()) {
+    if (outResp) *outResp = "wifi not connected";
+    if (outCode) *outCode = -1;
+    record(FE_WIFI);
+    return false;
+  }
+
+  StaticJsonDocument<512> doc;
+  doc["msg_type"] = "text";
+  JsonObject content = doc.createNestedObject("content");
+  content["text"] = text;
+
+  String payload;
+  serializeJson(doc, payload);
+
+  std::unique_ptr<BearSSL::WiFiClientSecure> client(new BearSSL::WiFiClientSecure);
+  client->setInsecure();
+
+  HTTPClient https;
+  if (!https.begin(*client, hook)) {
+    if (outResp) *outResp = "https.begin failed";
+    if (outCode) *outCode = -2;
+    record(FE_CONNECT);
+    return false;
+  }
+
+  https.addHeader("Content-Type", "application/json; charset=utf-8");
+  int code = https.POST((uint8_t*)payload.c_str(), payload.length());
+  heapMark();
+  String resp = https.getString();
+  https.end();
+
+  r.status = code;
+  r.bytes = resp.length();
+  if (code == HTTPC_ERROR_READ_TIMEOUT) record(FE_TIMEOUT);
+  else if (code == HTTPC_ERROR_CONNECTION_FAILED) record(FE_CONNECT);
+  else if (code < 0) record(FE_CLOSED);
+  else if (code >= 500) record(FE_HTTP_5XX);
+  else if (code >= 400) record(FE_HTTP_4XX);
+  else if (code >= 300) record(FE_HTTP_OTHER);
+  else record(FE_OK);
+
+  if (outResp) *outResp = resp;
+  if (outCode) *outCode = code;
+  return (code > 0 && code < 300);
+}
+
+static void handlePushSys() {
+  String resp;
+  int code = 0;
+  bool ok = postFeishuText(buildSysReportText(), &resp, &code);
+
+  StaticJsonDocument<512> out;
+  out["ok"] = ok;
+  out["http_code"] = code;
+  out["resp"] = resp;
+
+  String body;
+  serializeJson(out, body);
+  server.send(ok ? 200 : 500, "application/json; charset=utf-8", body);
+}
+
+static const size_t SYS_DOC_BYTES = 768;
+
+static void sysSend(JsonDocument& doc, const char* key, char sep = ',') {
+  String s;
+  if (key) {
+    s = sep;
+    s += '"';
+    s += key;
+    s += "\":";
+  }
+  serializeJson(doc, s);
+  if (!key) s.remove(s.length() - 1);
+  heapMark();
+  server.sendContent(s);
+  doc.clear();
+}
+
+static void handleSysJson() {
+  DynamicJsonDocument out(SYS_DOC_BYTES);
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send(200, "application/json; charset=utf-8", "");
+
+  out["uptime_ms"] = millis();
+  out["uptime"] = formatUptime(millis());
+  out["free_heap"] = ESP.getFreeHeap();
+  out["heap_low"] = heapLow;
+
+  #if defined(ARDUINO_ESP8266_MAJOR)
+    out["heap_frag_pct"] = ESP.getHeapFragmentation();
+    out["max_free_block"] = ESP.getMaxFreeBlockSize();
+    out["max_free_block_low"] = blockLow;
+  #endif
+
+  out["flash_size"] = ESP.getFlashChipSize();
+  out["sketch_size"] = ESP.getSketchSize();
+  out["free_sketch"] = ESP.getFreeSketchSpace();
+  out["rssi"] = WiFi.isConnected() ? WiFi.RSSI() : 0;
+  out["ssid"] = WiFi.isConnected() ? WiFi.SSID() : "";
+  out["ip"] = WiFi.isConnected() ? WiFi.localIP().toString() : "";
+  out["chip_id"] = ESP.getChipId();
+  out["time_synced"] = clockSynced();
+  out["epoch"] = clockSynced() ? (uint32_t)now() : 0;
+  sysSend(out, nullptr);
+
+  JsonObject conn = out.to<JsonObject>();
+  conn["opened"] = apiConnOpened;
+  conn["reused"] = apiConnReused;
+  conn["dropped"] = apiConnDropped;
+  conn["not_modified"] = apiNotModified;
+  sysSend(out, "api_conn");
+
+  JsonObject stream = out.to<JsonObject>();
+  stream["enabled"] = (cfg.stream != 0);
+  stream["live"] = streamUp;
+  stream["connects"] = streamConnects;
+  stream["events"] = streamEvents;
+  sysSend(out, "stream");
+
+  JsonObject kl = out.to<JsonObject>();
+  kl["interval"] = KI_NAMES[kView];
+  JsonObject tiers = kl.createNestedObject("tiers");
+  for (uint8_t i = 0; i < KI_COUNT; i++) {
+    tiers[KI_NAMES[i]] = !kTiers[i].ready ? "empty" : kTiers[i].stale ? "stale" : "ready";
+  }
+  sysSend(out, "klines");
+
+  JsonObject pre = out.to<JsonObject>();
+  pre["req_budget"] = cfg.prefetchReq;
+  pre["kb_budget"] = cfg.prefetchKB;
+  pre["window_req"] = pf.reqs;
+  pre["window_bytes"] = pf.bytes;
+  pre["total_req"] = pf.totalReqs;
+  pre["total_bytes"] = pf.totalBytes;
+  sysSend(out, "prefetch");
+
+  JsonObject disp = out.to<JsonObject>();
+  disp["frames_full"] = framesFull;
+  disp["frames_partial"] = framesPartial;
+  disp["last_frame_bytes"] = spiLastFrameBytes;
+  disp["avg_frame_bytes"] = (framesFull + framesPartial) ? spiFramesBytes / (framesFull + framesPartial) : 0;
+  disp["spi_bytes"] = spiBytes;
+  disp["spi_windows"] = spiWindows;
+  disp["sprite_bytes"] = pool.bytes;
+  disp["sprite_rows"] = pool.rows;
+  disp["sprite_pushes"] = pool.pushes;
+  disp["direct_flushes"] = pool.direct;
+  disp["atlas_bytes"] = atlas.used;
+  disp["atlas_glyphs"] = atlas.blits;
+  disp["font_glyphs"] = atlas.misses;
+  disp["draw_char_ns"] = atlas.drawCharNs;
+  disp["atlas_push_ns"] = atlas.pushNs;
+  disp["atlas_blit_ns"] = atlas.blitNs;
+  sysSend(out, "display");
+
+  JsonObject frames = out.to<JsonObject>();
+  frames["target_fps"] = 1000 / FRAME_MS;
+  frames["count"] = fs.frames;
+  frames["coalesced"] = fs.coalesced;
+  frames["last_us"] = fs.lastUs;
+  frames["avg_us"] = fs.frames ? fs.sumUs / fs.frames : 0;
+  frames["max_us"] = fs.maxUs;
+  frames["idle_pct"] = fs.idlePct;
+  sysSend(out, "frames");
+
+  JsonObject dns = out.to<JsonObject>();
+  dns["hits"] = dnsHits;
+  dns["misses"] = dnsMisses;
+  dns["fails"] = dnsFails;
+  sysSend(out, "dns");
+
+  JsonObject br = out.to<JsonObject>();
+  br["state"] = BREAKER_NAMES[breaker.state];
+  br["host"] = (const char*)breaker.host;
+  br["fails"] = breaker.fails;
+  br["trips"] = breaker.trips;
+  br["retry_in_ms"] = (breaker.state == BR_OPEN && (int32_t)(breaker.retryAt - millis()) > 0) ? breaker.retryAt - millis() : 0;
+
+  uint8_t cachedPrices = 0;
+  for (int i = 0; i < PRICE_CACHE_SLOTS; i++) {
+    if (priceCache[i].symbol[0]) cachedPrices++;
+  }
+  uint8_t cachedKlines = 0;
+  for (int i = 0; i < KLINE_CACHE_SLOTS; i++) {
+    if (stashUsable(klineCache[i])) cachedKlines++;
+  }
+  sysSend(out, "breaker");
+
+  JsonObject cache = out.to<JsonObject>();
+  cache["prices"] = cachedPrices;
+  cache["klines"] = cachedKlines;
+  sysSend(out, "cache");
+
+  server.sendContent(",\"endpoints\":");
+  for (uint8_t i = 0; i < EP_COUNT; i++) {
+    const EndpointStats& e = epStats[i];
+    JsonObject o = out.to<JsonObject>();
+    o["requests"] = e.requests;
+    o["bytes"] = e.bytes;
+    o["retries"] = e.retries;
+    o["avg_ms"] = e.requests ? e.sumMs / e.requests : 0;
+    JsonObject errs = o.createNestedObject("errors");
+    for (uint8_t k = 1; k < FE_COUNT; k++) {
+      if (e.errors[k]) errs[FETCH_ERR_NAMES[k]] = e.errors[k];
+    }
+    if (e.requests) {
+      JsonObject last = o.createNestedObject("last");
+      last["result"] = FETCH_ERR_NAMES[e.last.err];
+      last["status"] = e.last.status;
+      last["json"] = DeserializationError(e.last.json).c_str();
+      last["bytes"] = e.last.bytes;
+      last["ms"] = e.last.durationUs / 1000;
+    }
+    sysSend(out, EP_NAMES[i], i ? ',' : '{');
+  }
+
+  server.sendContent("},\"latency_us\":");
+  for (uint8_t i = 0; i < LAT_COUNT; i++) {
+    LatSummary ls = latSummary((LatStage)i);
+    JsonObject o = out.to<JsonObject>();
+    o["n"] = ls.n;
+    o["min"] = ls.min;
+    o["avg"] = ls.avg;
+    o["max"] = ls.max;
+    o["p95"] = ls.p95;
+    sysSend(out, LAT_NAMES[i], i ? ',' : '{');
+  }
+  server.sendContent("}}");
+  server.sendContent("");
+}
+
+static const size_t METRICS_CHUNK = 1024;
+
+static void metricLine(String& out, const char* name, const char* labels, uint32_t v) {
+  char buf[112];
+  snprintf(buf, sizeof(buf), "%s%s %lu\n", name, labels, (unsigned long)v);
+  out += buf;
+  if (out.length() < METRICS_CHUNK) return;
+  heapMark();
+  server.sendContent(out);
+  out = "";
+}
+
+static void handleMetrics() {
+  String out;
+  out.reserve(METRICS_CHUNK + 256);
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send(200, "text/plain; version=0.0.4", "");
+
+  out += "# TYPE coin_uptime_seconds gauge\n";
+  metricLine(out, "coin_uptime_seconds", "", millis() / 1000UL);
+  out += "# TYPE coin_free_heap_bytes gauge\n";
+  metricLine(out, "coin_free_heap_bytes", "", ESP.getFreeHeap());
+  out += "# HELP coin_free_heap_low_bytes Lowest free heap seen since boot.\n";
+  out += "# TYPE coin_free_heap_low_bytes gauge\n";
+  metricLine(out, "coin_free_heap_low_bytes", "", heapLow);
+  out += "# TYPE coin_wifi_rssi_dbm gauge\n";
+  out += "coin_wifi_rssi_dbm " + String(WiFi.isConnected() ? WiFi.RSSI() : 0) + "\n";
+
+  out += "# TYPE coin_api_conn_total counter\n";
+  metricLine(out, "coin_api_conn_total", "{event=\"opened\"}", apiConnOpened);
+  metricLine(out, "coin_api_conn_total", "{event=\"reused\"}", apiConnReused);
+  metricLine(out, "coin_api_conn_total", "{event=\"dropped\"}", apiConnDropped);
+  metricLine(out, "coin_api_conn_total", "{event=\"not_modified\"}", apiNotModified);
+  out += "# TYPE coin_stream_up gauge\n";
+  metricLine(out, "coin_stream_up", "", streamUp ? 1 : 0);
+  out += "# TYPE coin_stream_events_total counter\n";
+  metricLine(out, "coin_stream_events_total", "", streamEvents);
+  out += "# TYPE coin_display_frames_total counter\n";
+  metricLine(out, "coin_display_frames_total", "{kind=\"full\"}", framesFull);
+  metricLine(out, "coin_display_frames_total", "{kind=\"partial\"}", framesPartial);
+  out += "# HELP coin_display_spi_bytes_total Estimated bytes sent to the panel (pixels plus window setup).\n";
+  out += "# TYPE coin_display_spi_bytes_total counter\n";
+  metricLine(out, "coin_display_spi_bytes_total", "", spiBytes);
+  out += "# TYPE coin_display_spi_windows_total counter\n";
+  metricLine(out, "coin_display_spi_windows_total", "", spiWindows);
+  out += "# TYPE coin_display_frame_bytes gauge\n";
+  metricLine(out, "coin_display_frame_bytes", "", spiLastFrameBytes);
+  out += "# TYPE coin_frames_total counter\n";
+  metricLine(out, "coin_frames_total", "", fs.frames);
+  out += "# TYPE coin_frame_us gauge\n";
+  metricLine(out, "coin_frame_us", "{stat=\"last\"}", fs.lastUs);
+  metricLine(out, "coin_frame_us", "{stat=\"avg\"}", fs.frames ? fs.sumUs / fs.frames : 0);
+  metricLine(out, "coin_frame_us", "{stat=\"max\"}", fs.maxUs);
+  out += "# HELP coin_idle_percent Share of the last second the main loop spent sleeping.\n";
+  out += "# TYPE coin_idle_percent gauge\n";
+  metricLine(out, "coin_idle_percent", "", fs.idlePct);
+  out += "# TYPE coin_dns_lookups_total counter\n";
+  metricLine(out, "coin_dns_lookups_total", "{result=\"hit\"}", dnsHits);
+  metricLine(out, "coin_dns_lookups_total", "{result=\"miss\"}", dnsMisses);
+  metricLine(out, "coin_dns_lookups_total", "{result=\"fail\"}", dnsFails);
+  out += "# HELP coin_breaker_state API circuit breaker: 0 closed, 1 open, 2 half-open.\n";
+  out += "# TYPE coin_breaker_state gauge\n";
+  metricLine(out, "coin_breaker_state", "", breaker.state);
+  out += "# TYPE coin_breaker_trips_total counter\n";
+  metricLine(out, "coin_breaker_trips_total", "", breaker.trips);
+  out += "# TYPE coin_prefetch_requests_total counter\n";
+  metricLine(out, "coin_prefetch_requests_total", "", pf.totalReqs);
+  out += "# TYPE coin_prefetch_bytes_total counter\n";
+  metricLine(out, "coin_prefetch_bytes_total", "", pf.totalBytes);
+
+  static const char* const STATS[] = {"min", "avg", "max", "p95"};
+  out += "# HELP coin_latency_us Rolling latency over the last 32 samples per stage.\n";
+  out += "# TYPE coin_latency_us gauge\n";
+  for (uint8_t i = 0; i < LAT_COUNT; i++) {
+    LatSummary ls = latSummary((LatStage)i);
+    uint32_t vals[] = {ls.min, ls.avg, ls.max, ls.p95};
+    for (uint8_t k = 0; k < 4; k++) {
+      char labels[48];
+      snprintf(labels, sizeof(labels), "{stage=\"%s\",stat=\"%s\"}", LAT_NAMES[i], STATS[k]);
+      metricLine(out, "coin_latency_us", labels, vals[k]);
+    }
+  }
+  out += "# TYPE coin_latency_samples_total counter\n";
+  for (uint8_t i = 0; i < LAT_COUNT; i++) {
+    char labels[32];
+    snprintf(labels, sizeof(labels), "{stage=\"%s\"}", LAT_NAMES[i]);
+    metricLine(out, "coin_latency_samples_total", labels, lat[i].count);
+  }
+
+  out += "# TYPE coin_fetch_results_total counter\n";
+  for (uint8_t i = 0; i < EP_COUNT; i++) {
+    for (uint8_t k = 0; k < FE_COUNT; k++) {
+      if (k != FE_OK && !epStats[i].errors[k]) continue;
+      char labels[64];
+      snprintf(labels, sizeof(labels), "{endpoint=\"%s\",result=\"%s\"}", EP_NAMES[i], FETCH_ERR_NAMES[k]);
+      metricLine(out, "coin_fetch_results_total", labels, epStats[i].errors[k]);
+    }
+  }
+  out += "# TYPE coin_fetch_bytes_total counter\n";
+  for (uint8_t i = 0; i < EP_COUNT; i++) {
+    char labels[32];
+    snprintf(labels, sizeof(labels), "{endpoint=\"%s\"}", EP_NAMES[i]);
+    metricLine(out, "coin_fetch_bytes_total", labels, epStats[i].bytes);
+  }
+  out += "# TYPE coin_fetch_duration_ms histogram\n";
+  for (uint8_t i = 0; i < EP_COUNT; i++) {
+    const EndpointStats& e = epStats[i];
+    char labels[48];
+    uint32_t cum = 0;
+    for (uint8_t b = 0; b < HIST_BUCKETS; b++) {
+      cum += e.hist[b];
+      if (b < HIST_BUCKETS - 1) snprintf(labels, sizeof(labels), "{endpoint=\"%s\",le=\"%u\"}", EP_NAMES[i], (unsigned int)HIST_BOUNDS_MS[b]);
+      else snprintf(labels, sizeof(labels), "{endpoint=\"%s\",le=\"+Inf\"}", EP_NAMES[i]);
+      metricLine(out, "coin_fetch_duration_ms_bucket", labels, cum);
+    }
+    snprintf(labels, sizeof(labels), "{endpoint=\"%s\"}", EP_NAMES[i]);
+    metricLine(out, "coin_fetch_duration_ms_sum", labels, e.sumMs);
+    metricLine(out, "coin_fetch_duration_ms_count", labels, e.requests);
+  }
+
+  server.sendContent(out);
+  server.sendContent("");
+}
+
+static bool apiReady() {
+  String base = String(cfg.apiBase);
+  base.trim();
+  return base.length() > 0;
+}
+
+static const uint16_t FETCH_PRICE_TIMEOUT_MS = 5000;
+static const uint16_t FETCH_KLINE_TIMEOUT_MS = 8000;
+static const uint16_t FETCH_CONNECT_TIMEOUT_MS = 3000;
+static const uint32_t FETCH_SLICE_MS = 4;
+static const size_t FETCH_BODY_MAX = 512;
+static const int JOB_QUEUE_LEN = 8;
+
+enum FetchState : uint8_t {
+  FS_IDLE, FS_RESOLVE, FS_CONNECT, FS_SEND, FS_HEADERS, FS_BODY, FS_COMMIT
+};
+
+enum JobKind : uint8_t { JOB_PRICE, JOB_PRICES, JOB_KLINES };
+
+enum ChunkState : uint8_t { CH_SIZE, CH_EXT, CH_DATA, CH_DATA_END, CH_TRAILER, CH_DONE };
+
+struct ChunkDecoder {
+  ChunkState state;
+  uint32_t left;
+  bool lineSeen;
+};
+
+static void chunkReset(ChunkDecoder& d) {
+  d.state = CH_SIZE;
+  d.left = 0;
+  d.lineSeen = false;
+}
+
+static bool chunkFeed(ChunkDecoder& d, char c) {
+  switch (d.state) {
+    case CH_SIZE:
+    case CH_EXT:
+      if (c == '\n') {
+        d.state = d.left ? CH_DATA : CH_TRAILER;
+        d.lineSeen = false;
+      } else if (c == ';') {
+        d.state = CH_EXT;
+      } else if (d.state == CH_SIZE && isxdigit((unsigned char)c)) {
+        d.left = (d.left << 4) | (uint32_t)(c <= '9' ? c - '0' : (c | 0x20) - 'a' + 10);
+      }
+      return false;
+    case CH_DATA:
+      if (--d.left == 0) d.state = CH_DATA_END;
+      return true;
+    case CH_DATA_END:
+      if (c == '\n') d.state = CH_SIZE;
+      return false;
+    case CH_TRAILER:
+      if (c == '\n') {
+        if (!d.lineSeen) d.state = CH_DONE;
+        d.lineSeen = false;
+      } else if (c != '\r') {
+        d.lineSeen = true;
+      }
+      return false;
+    case CH_DONE:
+      break;
+  }
+  return false;
+}
+
+struct FetchJob {
+  JobKind kind;
+  Mode mode;
+  uint8_t slot;
+  uint8_t limit;
+  uint8_t interval;
+  bool prefetch;
+  char symbol[12];
+};
+
+struct ApiHost {
+  char host[64];
+  uint16_t port;
+  char prefix[64];
+};
+
+struct FetchCtx {
+  FetchState state;
+  FetchJob job;
+  ApiHost api;
+  IPAddress ip;
+  TcpDial dial;
+  uint32_t deadline;
+  uint16_t timeoutMs;
+  bool reused;
+  bool retried;
+  bool gotBytes;
+  bool statusSeen;
+  int status;
+  int32_t contentLength;
+  uint32_t bodyRecv;
+  bool chunked;
+  bool keepAlive;
+  bool msgpack;
+  uint32_t key;
+  char etag[48];
+  char lastMod[32];
+  uint32_t startUs;
+  uint32_t sentUs;
+  uint32_t parseUs;
+  uint32_t bytes;
+  uint8_t retries;
+  DeserializationError::Code jsonErr;
+  ChunkDecoder chunk;
+  char line[128];
+  uint8_t lineLen;
+  size_t bodyLen;
+  bool overflow;
+};
+
+static FetchCtx fx;
+
+enum MsgPackItem : uint8_t {
+  MP_NONE, MP_UINT, MP_INT, MP_F32, MP_F64, MP_STR, MP_STR_LEN, MP_ARR_LEN
+};
+
+struct KlineParser {
+  KlineStash* stash;
+  KTier* tier;
+  uint32_t sec;
+  uint32_t prevNewest;
+  bool prevReady;
+  bool roll;
+  bool active;
+  bool full;
+  bool gap;
+  bool bad;
+  bool inString;
+  uint8_t depth;
+  uint8_t field;
+  uint16_t rows;
+  uint32_t t;
+  float v[4];
+  char tok[24];
+  uint8_t tokLen;
+  MsgPackItem mpItem;
+  uint32_t mpNeed;
+  uint8_t mpBuf[8];
+  uint8_t mpHave;
+  uint32_t rowsLeft;
+  uint32_t fieldsLeft;
+};
+
+static KlineParser kp;
+
+static char fetchBody[FETCH_BODY_MAX + 1];
+static FetchJob jobQueue[JOB_QUEUE_LEN];
+static uint8_t jobHead = 0;
+static uint8_t jobCount = 0;
+static bool cycleActive = false;
+
+static char connHost[64] = "";
+static uint16_t connPort = 0;
+
+static bool pricesBatchOk = true;
+static uint32_t pricesBatchProbeAt = 0;
+static const uint32_t BATCH_REPROBE_MS = 10UL * 60UL * 1000UL;
+
+static const uint32_t SCHED_BACKOFF_MAX_MS = 5UL * 60UL * 1000UL;
+static const float SCHED_VOL_FAST = 0.0015f;
+
+struct SchedItem {
+  uint32_t due;
+  uint8_t fails;
+  float vol;
+};
+
+static SchedItem schedPrice[3];
+static SchedItem schedKline;
+static uint32_t kSeedRetryAt = 0;
+
+static const uint32_t STREAM_IDLE_MS = 45000;
+static const uint32_t STREAM_RETRY_MIN_MS = 2000;
+static const uint32_t STREAM_RETRY_MAX_MS = 60000;
+static const uint32_t STREAM_UNSUPPORTED_MS = 10UL * 60UL * 1000UL;
+
+enum StreamState : uint8_t { SS_OFF, SS_WAIT, SS_RESOLVE, SS_CONNECT, SS_HEADERS, SS_EVENTS };
+
+struct StreamCtx {
+  StreamState state;
+  Mode mode;
+  ApiHost api;
+  IPAddress ip;
+  TcpDial dial;
+  uint32_t retryAt;
+  uint32_t lastByteAt;
+  uint8_t fails;
+  int status;
+  bool statusSeen;
+  bool chunked;
+  ChunkDecoder chunk;
+  char line[192];
+  uint8_t lineLen;
+};
+
+static StreamCtx st;
+
+static bool streamLive() {
+  return st.state == SS_EVENTS && st.mode == currentMode;
+}
+
+static void streamRestart() {
+  dialAbort(st.dial);
+  streamClient.stop();
+  streamUp = false;
+  st.state = SS_OFF;
+  st.fails = 0;
+}
+
+static bool parseApiBase(ApiHost& a) {
+  const char* p = cfg.apiBase;
+  while (*p == ' ') p++;
+  if (strncasecmp(p, "https://", 8) == 0) return false;
+  if (strncasecmp(p, "http://", 7) == 0) p += 7;
+
+  size_t n = 0;
+  while (*p && *p != ':' && *p != '/' && n < sizeof(a.host) - 1) a.host[n++] = *p++;
+  a.host[n] = 0;
+  if (n == 0) return false;
+
+  a.port = 80;
+  if (*p == ':') {
+    p++;
+    a.port = (uint16_t)strtoul(p, nullptr, 10);
+    while (*p >= '0' && *p <= '9') p++;
+    if (a.port == 0) return false;
+  }
+
+  n = 0;
+  while (*p && *p != ' ' && n < sizeof(a.prefix) - 1) a.prefix[n++] = *p++;
+  while (n > 0 && a.prefix[n - 1] == '/') n--;
+  a.prefix[n] = 0;
+  return true;
+}
+
+static void apiConnReset() {
+  dialAbort(fx.dial);
+  wifiClient.stop();
+  connHost[0] = 0;
+  connPort = 0;
+}
+
+static const uint8_t BREAKER_THRESHOLD = 3;
+static const uint32_t BREAKER_PROBE_MIN_MS = 10000;
+static const uint32_t BREAKER_PROBE_MAX_MS = 5UL * 60UL * 1000UL;
+
+static void breakerReset() {
+  breaker.host[0] = 0;
+  breaker.port = 0;
+  breaker.state = BR_CLOSED;
+  breaker.fails = 0;
+  breaker.probeMs = 0;
+}
+
+static void breakerResult(const ApiHost& a, bool ok) {
+  if (breaker.port != a.port || strcmp(breaker.host, a.host) != 0) {
+    breakerReset();
+    strncpy(breaker.host, a.host, sizeof(breaker.host) - 1);
+    breaker.host[sizeof(breaker.host) - 1] = 0;
+    breaker.port = a.port;
+  }
+
+  uint32_t now = millis();
+  frameInvalidate(W_COUNTDOWN);
+  if (ok) {
+    if (breaker.state != BR_CLOSED) {
+      for (uint8_t i = 0; i < 3; i++) schedPrice[i] = {now, 0, schedPrice[i].vol};
+      schedKline = {now, 0, 0};
+    }
+    breaker.state = BR_CLOSED;
+    breaker.fails = 0;
+    breaker.probeMs = 0;
+    return;
+  }
+
+  if (breaker.fails < 255) breaker.fails++;
+  if (breaker.state == BR_CLOSED && breaker.fails < BREAKER_THRESHOLD) return;
+
+  if (breaker.state == BR_HALF_OPEN) {
+    breaker.probeMs *= 2;
+    if (breaker.probeMs > BREAKER_PROBE_MAX_MS) breaker.probeMs = BREAKER_PROBE_MAX_MS;
+  } else {
+    breaker.probeMs = BREAKER_PROBE_MIN_MS;
+    breaker.trips++;
+  }
+  breaker.state = BR_OPEN;
+  breaker.retryAt = now + breaker.probeMs;
+  jobHead = 0;
+  jobCount = 0;
+}
+
+static const char* slotSymbol(Mode m, uint8_t slot) {
+  if (m == MODE_SINGLE) return singleCoin.symbol;
+  if (m == MODE_TRIPLE) return tripleCoins[slot].symbol;
+  return holdings[slot].symbol;
+}
+
+static bool symbolVisible(const char* sym) {
+  uint8_t n = (currentMode == MODE_SINGLE) ? 1 : 3;
+  for (uint8_t i = 0; i < n; i++) {
+    if (strcmp(slotSymbol(currentMode, i), sym) == 0) return true;
+  }
+  return false;
+}
+
+static void cachePrice(const char* sym, Dec p, SchedItem* it) {
+  PriceEntry& e = priceCacheEntry(sym);
+  e.at = millis();
+
+  if (it && e.lastPrice >= 0 && e.price > 0) {
+    float rel = (float)(p > e.price ? p - e.price : e.price - p) / (float)e.price;
+    it->vol = it->vol * 0.7f + rel * 0.3f;
+  }
+  if (e.price == p && e.lastPrice >= 0) return;
+  e.lastPrice = e.price;
+  e.price = p;
+  priceCacheSync(e);
+  if (strcmp(sym, singleCoin.symbol) == 0) klineTick(p);
+  if (symbolVisible(sym)) frameInvalidate(W_VIEW);
+}
+
+static void applyPrice(Mode m, uint8_t slot, Dec p) {
+  cachePrice(slotSymbol(m, slot), p, m == currentMode ? &schedPrice[slot] : nullptr);
+}
+
+static void jobTouch(const FetchJob& j) {
+  uint32_t now = millis();
+  if (j.kind == JOB_KLINES) {
+    if (j.interval == KI_1M && kBase.ready) kAt = now;
+    return;
+  }
+  bool live = !j.prefetch && j.mode == currentMode;
+  if (j.kind == JOB_PRICE) {
+    PriceEntry* e = priceCacheFind(j.symbol);
+    if (e) e->at = now;
+    if (live) schedPrice[j.slot].vol *= 0.7f;
+    return;
+  }
+  for (uint8_t i = 0; i < 3; i++) {
+    PriceEntry* e = priceCacheFind(slotSymbol(j.mode, i));
+    if (e) e->at = now;
+    if (live) schedPrice[i].vol *= 0.7f;
+  }
+}
+
+static uint8_t klineTailLimit() {
+  if (!kBase.ready || kBase.len == 0) return KCOUNT;
+  if (!clockSynced()) return KLINE_TAIL;
+
+  uint32_t t = (uint32_t)now();
+  uint32_t newest = kNewest(kBase);
+  uint32_t behind = t > newest ? (t - newest) / KI_SECONDS[KI_1M] + 1 : 1;
+  if (behind < KLINE_TAIL) return KLINE_TAIL;
+  if (behind > KCOUNT) return KCOUNT;
+  return (uint8_t)behind;
+}
+
+static FetchJob* enqueueJob(JobKind kind, Mode m, uint8_t slot, bool prefetch = false) {
+  if (jobCount >= JOB_QUEUE_LEN) return nullptr;
+  FetchJob& j = jobQueue[(jobHead + jobCount) % JOB_QUEUE_LEN];
+  j.kind = kind;
+  j.mode = m;
+  j.slot = slot;
+  j.limit = 0;
+  j.prefetch = prefetch;
+  j.interval = KI_1M;
+  if (kind == JOB_KLINES) j.limit = klineTailLimit();
+  strncpy(j.symbol, slotSymbol(m, slot), sizeof(j.symbol) - 1);
+  j.symbol[sizeof(j.symbol) - 1] = 0;
+  jobCount++;
+  return &j;
+}
+
+static bool batchUsable() {
+  if (pricesBatchOk) return true;
+  if ((int32_t)(millis() - pricesBatchProbeAt) < 0) return false;
+  pricesBatchOk = true;
+  return true;
+}
+
+static bool schedDue(const SchedItem& it, uint32_t now) {
+  return (int32_t)(now - it.due) >= 0;
+}
+
+static uint32_t schedInterval(const SchedItem& it, bool kline) {
+  if (kline) return (uint32_t)cfg.klineSec * 1000UL;
+  if (it.vol >= SCHED_VOL_FAST) return (uint32_t)cfg.fastSec * 1000UL;
+  return (uint32_t)cfg.priceSec * 1000UL;
+}
+
+static uint32_t klineNextDue(uint32_t at) {
+  if (!clockSynced()) return at + (uint32_t)cfg.klineSec * 1000UL;
+
+  const uint64_t period = (uint64_t)KI_SECONDS[KI_1M] * 1000ULL;
+  uint64_t step = ((uint64_t)cfg.klineSec * 1000ULL + period - 1) / period * period;
+  uint64_t wall = wallMs() - (millis() - at) - KLINE_CLOSE_DELAY_MS;
+  uint64_t next = wall / period * period + step;
+  return at + (uint32_t)(next - wall);
+}
+
+static void schedDone(SchedItem& it, bool kline, bool ok) {
+  uint32_t now = millis();
+  frameInvalidate(W_COUNTDOWN);
+  if (ok) {
+    it.fails = 0;
+    it.due = kline ? klineNextDue(now) : now + schedInterval(it, kline);
+    return;
+  }
+
+  if (it.fails < 16) it.fails++;
+  uint32_t wait = schedInterval(it, kline);
+  for (uint8_t i = 1; i < it.fails && wait < SCHED_BACKOFF_MAX_MS; i++) wait *= 2;
+  if (wait > SCHED_BACKOFF_MAX_MS) wait = SCHED_BACKOFF_MAX_MS;
+  wait = wait - wait / 4 + (uint32_t)random((long)(wait / 2) + 1);
+  it.due = now + wait;
+}
+
+static void schedOnResult(const FetchJob& j, bool ok) {
+  if (j.prefetch || j.mode != currentMode) return;
+  if (j.kind == JOB_KLINES) {
+    if (j.interval == KI_1M) schedDone(schedKline, true, ok);
+  }
+  else if (j.kind == JOB_PRICE) schedDone(schedPrice[j.slot], false, ok);
+  else for (uint8_t i = 0; i < 3; i++) schedDone(schedPrice[i], false, ok);
+}
+
+static uint32_t schedResume(bool have, uint32_t at, uint32_t interval, uint32_t now) {
+  if (!have || now - at >= interval) return now;
+  return at + interval;
+}
+
+static void schedReset() {
+  uint32_t now = millis();
+  uint32_t priceMs = (uint32_t)cfg.priceSec * 1000UL;
+  for (uint8_t i = 0; i < 3; i++) {
+    PriceEntry* e = priceCacheFind(slotSymbol(currentMode, i));
+    schedPrice[i] = {schedResume(e && e->lastPrice >= 0, e ? e->at : 0, priceMs, now), 0, 0};
+  }
+  uint32_t kDue = klineNextDue(kAt);
+  schedKline = {(kBase.ready && (int32_t)(kDue - now) > 0) ? kDue : now, 0, 0};
+  jobHead = 0;
+  jobCount = 0;
+  streamRestart();
+  frameInvalidate(W_COUNTDOWN);
+}
+
+static uint32_t schedRemaining(uint32_t now) {
+  if (breaker.state == BR_OPEN) return (int32_t)(breaker.retryAt - now) > 0 ? breaker.retryAt - now : 0;
+
+  uint32_t best = UINT32_MAX;
+  auto consider = [&](const SchedItem& it) {
+    uint32_t left = schedDue(it, now) ? 0 : it.due - now;
+    if (left < best) best = left;
+  };
+
+  if (currentMode == MODE_SINGLE) {
+    consider(schedPrice[0]);
+    consider(schedKline);
+  } else {
+    for (uint8_t i = 0; i < 3; i++) consider(schedPrice[i]);
+  }
+  return best;
+}
+
+static bool breakerPoll(uint32_t now) {
+  if (breaker.state == BR_CLOSED) return false;
+  if (breaker.state == BR_HALF_OPEN) breaker.state = BR_OPEN;
+  if ((int32_t)(now - breaker.retryAt) >= 0) {
+    breaker.state = BR_HALF_OPEN;
+    enqueueJob(JOB_PRICE, currentMode, 0);
+    cycleActive = true;
+  }
+  return true;
+}
+
+static const uint32_t KLINE_SEED_RETRY_MS = 60000;
+
+static void klineSeedPoll(uint32_t now) {
+  if ((int32_t)(now - kSeedRetryAt) < 0) return;
+
+  if (kView == KI_1M || (kTiers[kView].ready && !kTiers[kView].stale)) return;
+
+  FetchJob* j = enqueueJob(JOB_KLINES, MODE_SINGLE, 0);
+  if (!j) return;
+  j->interval = kView;
+  j->limit = KCOUNT;
+}
+
+static const uint32_t PREFETCH_WINDOW_MS = 60UL * 60UL * 1000UL;
+static const uint32_t PREFETCH_GAP_MS = 2000;
+static const uint32_t PREFETCH_LEAD_MS = 1500;
+static const uint32_t PREFETCH_PRICE_AGE_MS = 60000;
+static const uint32_t PREFETCH_KLINE_AGE_MS = 5UL * 60UL * 1000UL;
+
+static bool priceStale(const char* sym, uint32_t now) {
+  PriceEntry* e = priceCacheFind(sym);
+  return !e || e->lastPrice < 0 || now - e->at >= PREFETCH_PRICE_AGE_MS;
+}
+
+static bool prefetchSymbol(JobKind kind, const char* sym, uint8_t interval = KI_1M) {
+  FetchJob* j = enqueueJob(kind, MODE_SINGLE, 0, true);
+  if (!j) return false;
+  strncpy(j->symbol, sym, sizeof(j->symbol) - 1);
+  j->symbol[sizeof(j->symbol) - 1] = 0;
+  j->interval = interval;
+  if (kind == JOB_KLINES && (interval != KI_1M || strcmp(sym, singleCoin.symbol) != 0)) j->limit = KCOUNT;
+  return true;
+}
+
+static bool prefetchPlan(uint32_t now) {
+  if (currentMode != MODE_SINGLE) {
+    if (!kBase.ready || now - kAt >= PREFETCH_KLINE_AGE_MS) return prefetchSymbol(JOB_KLINES, singleCoin.symbol);
+    if (!kTiers[kView].ready || kTiers[kView].stale) return prefetchSymbol(JOB_KLINES, singleCoin.symbol, kView);
+    if (priceStale(singleCoin.symbol, now)) return prefetchSymbol(JOB_PRICE, singleCoin.symbol);
+  }
+
+  for (uint8_t m = MODE_TRIPLE; m <= MODE_HOLDINGS; m++) {
+    if (m == currentMode) continue;
+    for (uint8_t i = 0; i < 3; i++) {
+      const char* sym = slotSymbol((Mode)m, i);
+      if (!priceStale(sym, now)) continue;
+      if (batchUsable()) return enqueueJob(JOB_PRICES, (Mode)m, 0, true) != nullptr;
+      return prefetchSymbol(JOB_PRICE, sym);
+    }
+  }
+
+  char next[12];
+  if (!rotationNext(singleCoin.symbol, next, sizeof(next))) return false;
+  KlineStash* s = klineStashFind(next);
+  if (!s || !s->tiers[kView].ready || now - s->at >= PREFETCH_KLINE_AGE_MS) return prefetchSymbol(JOB_KLINES, next, kView);
+  if (priceStale(next, now)) return prefetchSymbol(JOB_PRICE, next);
+  return false;
+}
+
+static void prefetchPoll(uint32_t now) {
+  if (cfg.prefetchReq == 0 || cfg.prefetchKB == 0) return;
+  if (!apiReady() || !WiFi.isConnected()) return;
+  if (now - pf.lastAt < PREFETCH_GAP_MS || schedRemaining(now) < PREFETCH_LEAD_MS) return;
+
+  if (now - pf.windowAt >= PREFETCH_WINDOW_MS) {
+    pf.windowAt = now;
+    pf.reqs = 0;
+    pf.bytes = 0;
+  }
+  if (pf.reqs >= cfg.prefetchReq || pf.bytes >= (uint32_t)cfg.prefetchKB * 1024UL) return;
+
+  pf.lastAt = now;
+  if (!prefetchPlan(now)) return;
+  pf.reqs++;
+  pf.totalReqs++;
+}
+
+static void schedPoll(uint32_t now) {
+  if (cycleActive) return;
+  if (breakerPoll(now)) return;
+
+  if (streamLive()) {
+    for (uint8_t i = 0; i < 3; i++) {
+      if (!schedDue(schedPrice[i], now)) continue;
+      schedPrice[i].due = now + schedInterval(schedPrice[i], false);
+      frameInvalidate(W_COUNTDOWN);
+    }
+  }
+
+  if (currentMode == MODE_SINGLE) {
+    if (schedDue(schedPrice[0], now)) enqueueJob(JOB_PRICE, MODE_SINGLE, 0);
+    if (schedDue(schedKline, now)) enqueueJob(JOB_KLINES, MODE_SINGLE, 0);
+  } else {
+    bool anyDue = false;
+    for (uint8_t i = 0; i < 3; i++) {
+      if (schedDue(schedPrice[i], now)) anyDue = true;
+    }
+    if (anyDue && batchUsable()) {
+      enqueueJob(JOB_PRICES, currentMode, 0);
+    } else {
+      for (uint8_t i = 0; i < 3; i++) {
+        if (schedDue(schedPrice[i], now)) enqueueJob(JOB_PRICE, currentMode, i);
+      }
+    }
+  }
+
+  if (jobCount == 0 && currentMode == MODE_SINGLE) klineSeedPoll(now);
+  if (jobCount == 0) prefetchPoll(now);
+  if (jobCount > 0) cycleActive = true;
+}
+
+static bool jobTargetsRing(const FetchJob& j) {
+  return !j.prefetch || strcmp(j.symbol, singleCoin.symbol) == 0;
+}
+
+static bool jobStillWanted(const FetchJob& j) {
+  if (j.prefetch && j.kind != JOB_PRICES) return true;
+  return strcmp(slotSymbol(j.mode, j.slot), j.symbol) == 0;
+}
+
+static void buildJobPath(const FetchJob& j, char* out, size_t len) {
+  if (j.kind == JOB_PRICE) {
+    snprintf(out, len, "%s/price?symbol=%s", fx.api.prefix, j.symbol);
+  } else if (j.kind == JOB_KLINES) {
+    snprintf(out, len, "%s/klines?symbol=%s&interval=%s&limit=%u", fx.api.prefix, j.symbol, KI_NAMES[j.interval], (unsigned int)j.limit);
+  } else {
+    int n = snprintf(out, len, "%s/prices?symbols=", fx.api.prefix);
+    for (uint8_t i = 0; i < 3 && n < (int)len; i++) {
+      n += snprintf(out + n, len - n, i ? ",%s" : "%s", slotSymbol(j.mode, i));
+    }
+  }
+}
+
+struct Validator {
+  uint32_t key;
+  uint32_t used;
+  bool isDate;
+  char tag[48];
+};
+
+static const int VALIDATOR_SLOTS = 8;
+static Validator validators[VALIDATOR_SLOTS];
+
+static uint32_t pathKey(const char* path) {
+  uint32_t h = 2166136261UL;
+  while (*path) {
+    h ^= (uint8_t)*path++;
+    h *= 16777619UL;
+  }
+  return h ? h : 1;
+}
+
+static Validator* validatorFind(uint32_t key) {
+  for (int i = 0; i < VALIDATOR_SLOTS; i++) {
+    if (validators[i].key == key) return &validators[i];
+  }
+  return nullptr;
+}
+
+static void validatorStore() {
+  const char* tag = fx.etag[0] ? fx.etag : fx.lastMod;
+  Validator* v = validatorFind(fx.key);
+  if (!tag[0]) {
+    if (v) v->key = 0;
+    return;
+  }
+
+  if (!v) {
+    v = &validators[0];
+    for (int i = 1; i < VALIDATOR_SLOTS; i++) {
+      if (validators[i].used < v->used) v = &validators[i];
+    }
+  }
+  v->key = fx.key;
+  v->used = millis();
+  v->isDate = !fx.etag[0];
+  strncpy(v->tag, tag, sizeof(v->tag) - 1);
+  v->tag[sizeof(v->tag) - 1] = 0;
+}
+
+static bool slotHasPrice(Mode m, uint8_t slot) {
+  if (m == MODE_SINGLE) return singleCoin.lastPrice >= 0;
+  if (m == MODE_TRIPLE) return tripleCoins[slot].lastPrice >= 0;
+  return holdings[slot].lastPrice >= 0;
+}
+
+static bool jobHasData(const FetchJob& j) {
+  if (j.kind == JOB_KLINES) return j.limit < KCOUNT && kTiers[j.interval].ready;
+  if (j.kind == JOB_PRICE) {
+    PriceEntry* e = priceCacheFind(j.symbol);
+    return e && e->lastPrice >= 0;
+  }
+  for (uint8_t i = 0; i < 3; i++) {
+    if (!slotHasPrice(j.mode, i)) return false;
+  }
+  return true;
+}
+
+static void validatorHeader(char* out, size_t len) {
+  out[0] = 0;
+  if (!jobHasData(fx.job)) return;
+
+  Validator* v = validatorFind(fx.key);
+  if (!v) return;
+  v->used = millis();
+  snprintf(out, len, "%s: %s\r\n", v->isDate ? "If-Modified-Since" : "If-None-Match", v->tag);
+}
+
+static void fetchResetResponse() {
+  fx.gotBytes = false;
+  fx.statusSeen = false;
+  fx.status = 0;
+  fx.contentLength = -1;
+  fx.bodyRecv = 0;
+  fx.chunked = false;
+  fx.keepAlive = true;
+  fx.msgpack = false;
+  fx.etag[0] = 0;
+  fx.lastMod[0] = 0;
+  kp.stash = nullptr;
+  kp.tier = nullptr;
+  fx.parseUs = 0;
+  fx.jsonErr = DeserializationError::Ok;
+  chunkReset(fx.chunk);
+  fx.lineLen = 0;
+  fx.bodyLen = 0;
+  fx.overflow = false;
+  kp.active = false;
+}
+
+static void fetchConnect() {
+  fetchResetResponse();
+  fx.deadline = millis() + fx.timeoutMs;
+
+  if (wifiClient.connected() && connPort == fx.api.port && strcmp(connHost, fx.api.host) == 0) {
+    fx.reused = true;
+    fx.state = FS_SEND;
+    return;
+  }
+
+  if (connHost[0]) apiConnReset();
+  fx.reused = false;
+  fx.state = FS_RESOLVE;
+}
+
+static bool fetchBegin() {
+  while (jobCount > 0) {
+    fx.job = jobQueue[jobHead];
+    jobHead = (jobHead + 1) % JOB_QUEUE_LEN;
+    jobCount--;
+
+    if (!jobStillWanted(fx.job)) continue;
+    if (!apiReady() || !parseApiBase(fx.api)) {
+      if (fx.job.kind == JOB_KLINES && jobTargetsRing(fx.job) && fx.job.interval == KI_1M) setKReady(kBase, false);
+      schedOnResult(fx.job, false);
+      continue;
+    }
+
+    fx.timeoutMs = (fx.job.kind == JOB_KLINES) ? FETCH_KLINE_TIMEOUT_MS : FETCH_PRICE_TIMEOUT_MS;
+    fx.retried = false;
+    fx.retries = 0;
+    fx.bytes = 0;
+    fx.startUs = micros();
+    fetchConnect();
+    return true;
+  }
+  return false;
+}
+
+static bool fetchErrTransport(FetchErr err) {
+  return err >= FE_WIFI && err <= FE_CLOSED;
+}
+
+static void fetchFinish(FetchErr err) {
+  bool transportOk = !fetchErrTransport(err);
+  if (!transportOk || !fx.keepAlive) apiConnReset();
+  breakerResult(fx.api, transportOk && err != FE_HTTP_5XX);
+  if (!transportOk && fx.job.kind == JOB_KLINES) {
+    if (kp.tier) setKReady(*kp.tier, false);
+    else if (jobTargetsRing(fx.job) && fx.job.interval == KI_1M) setKReady(kBase, false);
+    if (fx.job.interval != KI_1M) kSeedRetryAt = millis() + KLINE_SEED_RETRY_MS;
+  }
+  schedOnResult(fx.job, err == FE_OK);
+  if (fx.job.prefetch) {
+    pf.bytes += fx.bytes;
+    pf.totalBytes += fx.bytes;
+  }
+
+  FetchResult r = {err, fx.status, fx.jsonErr, fx.bytes, micros() - fx.startUs, fx.retries};
+  if (!transportOk) r.status = 0;
+  fetchRecord(fx.job.kind == JOB_PRICE ? EP_PRICE : fx.job.kind == JOB_PRICES ? EP_PRICES : EP_KLINES, r);
+  fx.state = FS_IDLE;
+}
+
+static void fetchFail(FetchErr err) {
+  if (fx.reused && !fx.retried && !fx.gotBytes) {
+    apiConnDropped++;
+    apiConnReset();
+    fx.retried = true;
+    fx.retries++;
+    fetchConnect();
+    return;
+  }
+  fetchFinish(err);
+}
+
+static DeserializationError decodeBody(JsonDocument& doc) {
+  DeserializationError err = DeserializationError::NoMemory;
+  if (fx.msgpack && !fx.overflow) err = deserializeMsgPack(doc, fetchBody, fx.bodyLen);
+  else if (!fx.overflow) err = deserializeJson(doc, fetchBody, fx.bodyLen);
+  fx.jsonErr = err.code();
+  return err;
+}
+
+static void commitPrice() {
+  if (fx.status != 200) return;
+
+  SchedItem* jobSched = (fx.job.prefetch || fx.job.mode != currentMode) ? nullptr : &schedPrice[fx.job.slot];
+  Dec p;
+  if (!fx.msgpack && !fx.overflow && scanDec(fetchBody, "price", p)) {
+    cachePrice(fx.job.symbol, p, jobSched);
+    return;
+  }
+
+  DynamicJsonDocument doc(256);
+  if (decodeBody(doc)) return;
+  cachePrice(fx.job.symbol, jsonDec(doc["price"]), jobSched);
+}
+
+static void commitPrices() {
+  Mode m = fx.job.mode;
+
+  if (fx.status != 200) {
+    if (fx.status >= 500 && fx.status != 501) return;
+    pricesBatchOk = false;
+    pricesBatchProbeAt = millis() + BATCH_REPROBE_MS;
+    for (uint8_t i = 0; i < 3; i++) enqueueJob(JOB_PRICE, m, i, fx.job.prefetch);
+    return;
+  }
+
+  DynamicJsonDocument doc(512);
+  DeserializationError err = decodeBody(doc);
+  if (err || !doc.is<JsonArray>()) {
+    pricesBatchOk = false;
+    pricesBatchProbeAt = millis() + BATCH_REPROBE_MS;
+    for (uint8_t i = 0; i < 3; i++) enqueueJob(JOB_PRICE, m, i, fx.job.prefetch);
+    return;
+  }
+
+  bool got[3] = {false, false, false};
+  for (JsonObject row : doc.as<JsonArray>()) {
+    const char* sym = row["symbol"];
+    if (!sym || row["price"].isNull()) continue;
+    Dec p = jsonDec(row["price"]);
+    for (uint8_t i = 0; i < 3; i++) {
+      if (!got[i] && strcmp(sym, slotSymbol(m, i)) == 0) {
+        applyPrice(m, i, p);
+        got[i] = true;
+      }
+    }
+  }
+
+  for (uint8_t i = 0; i < 3; i++) {
+    if (!got[i]) enqueueJob(JOB_PRICE, m, i, fx.job.prefetch);
+  }
+}
+
+static void klineParseBegin() {
+  memset(&kp, 0, sizeof(kp));
+  kp.sec = KI_SECONDS[fx.job.interval];
+  if (!jobTargetsRing(fx.job)) {
+    kp.stash = klineStashSlot(fx.job.symbol);
+    kp.tier = &kp.stash->tiers[fx.job.interval];
+    klineReset(*kp.tier);
+    kp.tier->ready = false;
+    kp.full = true;
+    kp.active = true;
+    return;
+  }
+
+  kp.tier = &kTiers[fx.job.interval];
+  kp.roll = (fx.job.interval == KI_1M);
+  kp.prevReady = kp.tier->ready;
+  kp.prevNewest = kNewest(*kp.tier);
+  kp.full = (fx.job.limit >= KCOUNT);
+  kp.active = jobStillWanted(fx.job) && (kp.full || kp.tier->ready);
+  if (kp.active && kp.full) {
+    if (kp.roll) setKReady(*kp.tier, false);
+    klineReset(*kp.tier);
+  }
+}
+
+static void klineParseField() {
+  kp.tok[kp.tokLen] = 0;
+  if (kp.field == 0) kp.t = (uint32_t)(strtoull(kp.tok, nullptr, 10) / 1000ULL);
+  else if (kp.field <= 4) kp.v[kp.field - 1] = strtof(kp.tok, nullptr);
+  kp.tokLen = 0;
+}
+
+static void klineParseRow() {
+  kp.rows++;
+  if (kp.field < 4 || kp.gap) return;
+  if (kp.full) {
+    klinePush(*kp.tier, kp.t, kp.v[0], kp.v[1], kp.v[2], kp.v[3]);
+  } else if (!klineMerge(*kp.tier, kp.sec, kp.t, kp.v[0], kp.v[1], kp.v[2], kp.v[3])) {
+    kp.gap = true;
+    return;
+  }
+  if (kp.roll) klineRoll(kp.t, kp.v[0], kp.v[1], kp.v[2], kp.v[3]);
+}
+
+static void klineParseByte(char c) {
+  if (!kp.active) return;
+
+  if (kp.inString) {
+    if (c == '"') kp.inString = false;
+    else if (kp.depth == 2 && kp.tokLen < sizeof(kp.tok) - 1) kp.tok[kp.tokLen++] = c;
+    return;
+  }
+
+  switch (c) {
+    case '"':
+      kp.inString = true;
+      break;
+    case '[':
+      kp.depth++;
+      if (kp.depth == 2) { kp.field = 0; kp.tokLen = 0; }
+      break;
+    case ',':
+      if (kp.depth == 2) { klineParseField(); kp.field++; }
+      break;
+    case ']':
+      if (kp.depth == 2) { klineParseField(); klineParseRow(); }
+      if (kp.depth > 0) kp.depth--;
+      break;
+    case ' ': case '\t': case '\r': case '\n':
+      break;
+    default:
+      if (kp.depth == 2 && kp.tokLen < sizeof(kp.tok) - 1) kp.tok[kp.tokLen++] = c;
+      break;
+  }
+}
+
+static uint64_t mpBigEndian(uint8_t n) {
+  uint64_t v = 0;
+  for (uint8_t i = 0; i < n; i++) v = (v << 8) | kp.mpBuf[i];
+  return v;
+}
+
+static void klineMsgPackArray(uint32_t n) {
+  if (kp.depth == 0) {
+    kp.depth = 1;
+    kp.rowsLeft = n;
+  } else if (kp.depth == 1 && kp.rowsLeft > 0) {
+    kp.depth = 2;
+    kp.field = 0;
+    kp.fieldsLeft = n;
+    if (n == 0) kp.bad = true;
+  } else {
+    kp.bad = true;
+  }
+}
+
+static void klineMsgPackValue(MsgPackItem item, uint64_t raw) {
+  if (kp.depth != 2) { kp.bad = true; return; }
+
+  uint64_t u = 0;
+  float f = 0;
+  switch (item) {
+    case MP_UINT:
+      u = raw;
+      f = (float)raw;
+      break;
+    case MP_INT: {
+      int64_t i = (int64_t)raw;
+      u = (i < 0) ? 0 : (uint64_t)i;
+      f = (float)i;
+      break;
+    }
+    case MP_F32: {
+      uint32_t bits = (uint32_t)raw;
+      memcpy(&f, &bits, sizeof(f));
+      u = (f > 0) ? (uint64_t)f : 0;
+      break;
+    }
+    case MP_F64: {
+      double d;
+      memcpy(&d, &raw, sizeof(d));
+      f = (float)d;
+      u = (d > 0) ? (uint64_t)d : 0;
+      break;
+    }
+    case MP_STR:
+      kp.tok[kp.tokLen] = 0;
+      u = strtoull(kp.tok, nullptr, 10);
+      f = strtof(kp.tok, nullptr);
+      break;
+    default:
+      break;
+  }
+
+  if (kp.field == 0) kp.t = (uint32_t)(u / 1000ULL);
+  else if (kp.field <= 4) kp.v[kp.field - 1] = f;
 
-  if (!WiFi.isConnected()) {
-    if (outResp) *outResp = "wifi not connected";
-    if (outCode) *outCode = -1;
-    return false;
+  if (--kp.fieldsLeft > 0) {
+    kp.field++;
+    return;
   }
 
-  StaticJsonDocument<512> doc;
-  doc["msg_type"] = "text";
-  JsonObject content = doc.createNestedObject("content");
-  content["text"] = text;
+  klineParseRow();
+  kp.depth = 1;
+  if (--kp.rowsLeft == 0) kp.depth = 0;
+}
 
-  String payload;
-  serializeJson(doc, payload);
+static void klineMsgPackItemDone() {
+  MsgPackItem item = kp.mpItem;
+  kp.mpItem = MP_NONE;
+
+  if (item == MP_ARR_LEN) {
+    klineMsgPackArray((uint32_t)mpBigEndian(kp.mpHave));
+  } else if (item == MP_STR_LEN) {
+    kp.mpNeed = (uint32_t)mpBigEndian(kp.mpHave);
+    kp.tokLen = 0;
+    if (kp.mpNeed == 0) klineMsgPackValue(MP_STR, 0);
+    else kp.mpItem = MP_STR;
+  } else if (item == MP_STR) {
+    klineMsgPackValue(MP_STR, 0);
+  } else {
+    uint64_t raw = mpBigEndian(kp.mpHave);
+    if (item == MP_INT && kp.mpHave < 8) {
+      uint8_t shift = 64 - 8 * kp.mpHave;
+      raw = (uint64_t)(((int64_t)(raw << shift)) >> shift);
+    }
+    klineMsgPackValue(item, raw);
+  }
+}
 
-  std::unique_ptr<BearSSL::WiFiClientSecure> client(new BearSSL::WiFiClientSecure);
-  client->setInsecure();
+static void klineMsgPackByte(uint8_t b) {
+  if (!kp.active || kp.bad) return;
 
-  HTTPClient https;
-  if (!https.begin(*client, hook)) {
-    if (outResp) *outResp = "https.begin failed";
-    if (outCode) *outCode = -2;
-    return false;
+  if (kp.mpItem != MP_NONE) {
+    if (kp.mpItem == MP_STR) {
+      if (kp.tokLen < sizeof(kp.tok) - 1) kp.tok[kp.tokLen++] = (char)b;
+    } else {
+      kp.mpBuf[kp.mpHave++] = b;
+    }
+    if (--kp.mpNeed == 0) klineMsgPackItemDone();
+    return;
   }
 
-  https.addHeader("Content-Type", "application/json; charset=utf-8");
-  int code = https.POST((uint8_t*)payload.c_str(), payload.length());
-  String resp = https.getString();
-  https.end();
+  kp.mpHave = 0;
+  if (b <= 0x7f) { klineMsgPackValue(MP_UINT, b); return; }
+  if (b >= 0xe0) { klineMsgPackValue(MP_INT, (uint64_t)(int64_t)(int8_t)b); return; }
+  if (b >= 0x90 && b <= 0x9f) { klineMsgPackArray(b & 0x0f); return; }
+  if (b >= 0xa0 && b <= 0xbf) {
+    kp.tokLen = 0;
+    kp.mpNeed = b & 0x1f;
+    if (kp.mpNeed == 0) klineMsgPackValue(MP_STR, 0);
+    else kp.mpItem = MP_STR;
+    return;
+  }
 
-  if (outResp) *outResp = resp;
-  if (outCode) *outCode = code;
-  return (code > 0 && code < 300);
+  switch (b) {
+    case 0xc0: klineMsgPackValue(MP_UINT, 0); return;
+    case 0xca: kp.mpItem = MP_F32; kp.mpNeed = 4; return;
+    case 0xcb: kp.mpItem = MP_F64; kp.mpNeed = 8; return;
+    case 0xcc: kp.mpItem = MP_UINT; kp.mpNeed = 1; return;
+    case 0xcd: kp.mpItem = MP_UINT; kp.mpNeed = 2; return;
+    case 0xce: kp.mpItem = MP_UINT; kp.mpNeed = 4; return;
+    case 0xcf: kp.mpItem = MP_UINT; kp.mpNeed = 8; return;
+    case 0xd0: kp.mpItem = MP_INT; kp.mpNeed = 1; return;
+    case 0xd1: kp.mpItem = MP_INT; kp.mpNeed = 2; return;
+    case 0xd2: kp.mpItem = MP_INT; kp.mpNeed = 4; return;
+    case 0xd3: kp.mpItem = MP_INT; kp.mpNeed = 8; return;
+    case 0xd9: kp.mpItem = MP_STR_LEN; kp.mpNeed = 1; return;
+    case 0xda: kp.mpItem = MP_STR_LEN; kp.mpNeed = 2; return;
+    case 0xdc: kp.mpItem = MP_ARR_LEN; kp.mpNeed = 2; return;
+    case 0xdd: kp.mpItem = MP_ARR_LEN; kp.mpNeed = 4; return;
+    default: kp.bad = true; return;
+  }
 }
 
-static void handlePushSys() {
-  String resp;
-  int code = 0;
-  bool ok = postFeishuText(buildSysReportText(), &resp, &code);
+static void commitKlines() {
+  if (kp.bad) fx.jsonErr = DeserializationError::InvalidInput;
+  KTier* k = kp.tier;
+  bool ok = fx.status == 200 && k && kp.active && !kp.bad && !kp.gap && kp.depth == 0 && kp.rows > 0 && k->len > 0;
+  bool refetch = fx.status == 200 && !kp.full && (kp.gap || !kp.active);
+  if (!ok && !refetch && fx.status == 200 && fx.jsonErr == DeserializationError::Ok) fx.jsonErr = DeserializationError::InvalidInput;
+
+  if (kp.stash || !jobTargetsRing(fx.job)) {
+    if (!k) return;
+    k->ready = ok;
+    k->asOf = klineAsOf();
+    if (ok) kp.stash->at = millis();
+    return;
+  }
 
-  StaticJsonDocument<512> out;
-  out["ok"] = ok;
-  out["http_code"] = code;
-  out["resp"] = resp;
+  if (fx.job.interval != KI_1M) {
+    if (!ok) {
+      if (k) setKReady(*k, false);
+      kSeedRetryAt = millis() + KLINE_SEED_RETRY_MS;
+      return;
+    }
+    k->stale = false;
+    k->asOf = klineAsOf();
+    setKReady(*k, true);
+    return;
+  }
 
-  String body;
-  serializeJson(out, body);
-  server.send(ok ? 200 : 500, "application/json; charset=utf-8", body);
+  if (!ok) {
+    setKReady(kBase, false);
+    if (refetch) enqueueJob(JOB_KLINES, fx.job.mode, fx.job.slot, fx.job.prefetch);
+    return;
+  }
+  uint32_t from = kBase.t[kBase.head];
+  bool gap = !kp.prevReady || from > kp.prevNewest + KI_SECONDS[KI_1M];
+  for (uint8_t i = KI_1M + 1; i < KI_COUNT; i++) {
+    KTier& t = kTiers[i];
+    if (kp.full && (t.asOf ? from > t.asOf : gap)) t.stale = true;
+    else if (t.ready && !t.stale) t.asOf = klineAsOf();
+  }
+  setKReady(kBase, true);
+  kAt = millis();
 }
 
-static void handleSysJson() {
-  StaticJsonDocument<512> out;
-  out["uptime_ms"] = millis();
-  out["uptime"] = formatUptime(millis());
-  out["free_heap"] = ESP.getFreeHeap();
+static FetchErr fetchCommitResult() {
+  if (fx.status >= 500) return FE_HTTP_5XX;
+  if (fx.status >= 400) return FE_HTTP_4XX;
+  if (fx.status < 200 || (fx.status >= 300 && fx.status != 304)) return FE_HTTP_OTHER;
+  if (fx.jsonErr == DeserializationError::NoMemory) return FE_NO_MEMORY;
+  if (fx.jsonErr != DeserializationError::Ok) return FE_PARSE;
+  return FE_OK;
+}
 
-  #if defined(ARDUINO_ESP8266_MAJOR)
-    out["heap_frag_pct"] = ESP.getHeapFragmentation();
-    out["max_free_block"] = ESP.getMaxFreeBlockSize();
-  #endif
+static void fetchCommit() {
+  uint32_t t = micros();
+  fetchBody[fx.bodyLen] = 0;
+  if (fx.status == 304) {
+    apiNotModified++;
+    if (jobStillWanted(fx.job)) jobTouch(fx.job);
+  } else if (jobStillWanted(fx.job)) {
+    if (fx.status == 200) validatorStore();
+    if (fx.job.kind == JOB_PRICE) commitPrice();
+    else if (fx.job.kind == JOB_PRICES) commitPrices();
+    else commitKlines();
+  }
+  uint32_t end = micros();
+  latRecord(LAT_PARSE, fx.parseUs + (end - t));
+  latRecord(LAT_FETCH, end - fx.startUs);
+  fetchFinish(fetchCommitResult());
+}
 
-  out["flash_size"] = ESP.getFlashChipSize();
-  out["sketch_size"] = ESP.getSketchSize();
-  out["free_sketch"] = ESP.getFreeSketchSpace();
-  out["rssi"] = WiFi.isConnected() ? WiFi.RSSI() : 0;
-  out["ssid"] = WiFi.isConnected() ? WiFi.SSID() : "";
-  out["ip"] = WiFi.isConnected() ? WiFi.localIP().toString() : "";
-  out["chip_id"] = ESP.getChipId();
+static void fetchHeaderLine() {
+  char* l = fx.line;
 
-  String body;
-  serializeJson(out, body);
-  server.send(200, "application/json; charset=utf-8", body);
-}
+  if (!fx.statusSeen) {
+    fx.statusSeen = true;
+    if (strncmp(l, "HTTP/1.", 7) != 0) { fx.status = -1; return; }
+    if (l[7] == '0') fx.keepAlive = false;
+    const char* sp = strchr(l, ' ');
+    fx.status = sp ? atoi(sp + 1) : -1;
+    return;
+  }
 
-static bool apiReady() {
-  String base = String(cfg.apiBase);
-  base.trim();
-  return base.length() > 0;
+  char* colon = strchr(l, ':');
+  if (!colon) return;
+  *colon = 0;
+  char* v = colon + 1;
+  while (*v == ' ') v++;
+
+  if (strcasecmp(l, "Content-Length") == 0) {
+    fx.contentLength = atol(v);
+  } else if (strcasecmp(l, "Transfer-Encoding") == 0) {
+    if (strstr(v, "chunked")) fx.chunked = true;
+  } else if (strcasecmp(l, "ETag") == 0) {
+    strncpy(fx.etag, v, sizeof(fx.etag) - 1);
+    fx.etag[sizeof(fx.etag) - 1] = 0;
+  } else if (strcasecmp(l, "Last-Modified") == 0) {
+    strncpy(fx.lastMod, v, sizeof(fx.lastMod) - 1);
+    fx.lastMod[sizeof(fx.lastMod) - 1] = 0;
+  } else if (strcasecmp(l, "Content-Type") == 0) {
+    fx.msgpack = (strstr(v, "msgpack") != nullptr);
+  } else if (strcasecmp(l, "Connection") == 0) {
+    if (strncasecmp(v, "close", 5) == 0) fx.keepAlive = false;
+    else if (strncasecmp(v, "keep-alive", 10) == 0) fx.keepAlive = true;
+  }
 }
 
-static bool fetchPrice(Coin& c) {
-  if (!apiReady()) return false;
+static void fetchBodyByte(char c) {
+  fx.bodyRecv++;
+  if (fx.job.kind == JOB_KLINES && fx.status == 200) {
+    if (fx.msgpack) klineMsgPackByte((uint8_t)c);
+    else klineParseByte(c);
+  }
+  else if (fx.bodyLen < FETCH_BODY_MAX) fetchBody[fx.bodyLen++] = c;
+  else fx.overflow = true;
+}
 
-  char url[220];
-  snprintf(url, sizeof(url), "%s/price?symbol=%s", cfg.apiBase, c.symbol);
+static bool fetchBodyDone() {
+  if (fx.chunked) return fx.chunk.state == CH_DONE;
+  return fx.contentLength >= 0 && fx.bodyRecv >= (uint32_t)fx.contentLength;
+}
 
-  HTTPClient http;
-  http.setTimeout(5000);
-  http.setReuse(false);
+static void fetchFeed(const uint8_t* buf, int n) {
+  for (int i = 0; i < n && (fx.state == FS_HEADERS || fx.state == FS_BODY); i++) {
+    char c = (char)buf[i];
+
+    if (fx.state == FS_HEADERS) {
+      if (c == '\r') continue;
+      if (c != '\n') {
+        if (fx.lineLen < sizeof(fx.line) - 1) fx.line[fx.lineLen++] = c;
+        continue;
+      }
+      fx.line[fx.lineLen] = 0;
+      bool blank = (fx.lineLen == 0);
+      fx.lineLen = 0;
+      if (!blank) { fetchHeaderLine(); continue; }
+
+      if (fx.status == 100) { fx.statusSeen = false; continue; }
+      if (fx.status == 204 || fx.status == 304 || (!fx.chunked && fx.contentLength == 0)) {
+        fx.state = FS_COMMIT;
+      } else {
+        if (!fx.chunked && fx.contentLength < 0) fx.keepAlive = false;
+        if (fx.job.kind == JOB_KLINES && fx.status == 200) klineParseBegin();
+        fx.state = FS_BODY;
+      }
+      continue;
+    }
 
-  if (!http.begin(wifiClient, url)) return false;
-  int code = http.GET();
-  if (code != 200) { http.end(); return false; }
+    if (!fx.chunked || chunkFeed(fx.chunk, c)) fetchBodyByte(c);
+    if (fetchBodyDone()) fx.state = FS_COMMIT;
+  }
+}
 
-  DynamicJsonDocument doc(256);
-  DeserializationError err = deserializeJson(doc, http.getStream());
-  http.end();
-  if (err) return false;
+static void fetchRead() {
+  uint8_t buf[128];
+  int avail = wifiClient.available();
+
+  if (avail <= 0) {
+    if (!wifiClient.connected()) {
+      if (fx.state == FS_BODY && !fx.chunked && fx.contentLength < 0) fx.state = FS_COMMIT;
+      else fetchFail(FE_CLOSED);
+    } else if ((int32_t)(millis() - fx.deadline) >= 0) {
+      fx.retried = true;
+      fetchFail(FE_TIMEOUT);
+    }
+    return;
+  }
 
-  c.lastPrice = c.price;
-  c.price = doc["price"].as<float>();
-  return true;
+  int n = wifiClient.read(buf, avail < (int)sizeof(buf) ? avail : (int)sizeof(buf));
+  if (n <= 0) return;
+  uint32_t t = micros();
+  if (!fx.gotBytes) latRecord(LAT_TTFB, t - fx.sentUs);
+  fx.gotBytes = true;
+  fx.bytes += n;
+  fetchFeed(buf, n);
+  fx.parseUs += micros() - t;
 }
 
-static bool fetchHoldingPrice(Holding& h) {
-  if (!apiReady()) return false;
+static void fetchStep() {
+  uint32_t start = millis();
+
+  do {
+    switch (fx.state) {
+      case FS_IDLE:
+        if (!fetchBegin()) {
+          cycleActive = false;
+          return;
+        }
+        break;
+
+      case FS_RESOLVE: {
+        if (!WiFi.isConnected()) {
+          fetchFinish(FE_WIFI);
+          break;
+        }
+        NetPoll r = dnsPoll(fx.api.host, fx.ip);
+        if (r == NET_PENDING) return;
+        if (r == NET_FAILED) {
+          fetchFinish(FE_DNS);
+          break;
+        }
+        if (!dialStart(fx.dial, fx.ip, fx.api.port)) {
+          fetchFinish(FE_CONNECT);
+          break;
+        }
+        fx.state = FS_CONNECT;
+        return;
+      }
+
+      case FS_CONNECT: {
+        NetPoll r = dialPoll(fx.dial, wifiClient, FETCH_CONNECT_TIMEOUT_MS);
+        if (r == NET_PENDING) return;
+        latRecord(LAT_CONNECT, micros() - fx.dial.startUs);
+        if (r == NET_FAILED) {
+          fetchFinish(FE_CONNECT);
+          break;
+        }
+        wifiClient.setNoDelay(true);
+        strncpy(connHost, fx.api.host, sizeof(connHost) - 1);
+        connHost[sizeof(connHost) - 1] = 0;
+        connPort = fx.api.port;
+        fx.state = FS_SEND;
+        return;
+      }
+
+      case FS_SEND: {
+        char path[200];
+        buildJobPath(fx.job, path, sizeof(path));
+        fx.key = pathKey(path) ^ ((uint32_t)fx.job.mode << 24) ^ ((uint32_t)fx.job.slot << 16);
+        char cond[80];
+        validatorHeader(cond, sizeof(cond));
+        char req[400];
+        int n = snprintf(req, sizeof(req),
+                         "GET %s HTTP/1.1\r\nHost: %s:%u\r\nUser-Agent: ESP8266\r\nConnection: keep-alive\r\n%s%s\r\n",
+                         path, fx.api.host, (unsigned int)fx.api.port,
+                         cfg.wire == WIRE_MSGPACK ? "Accept: application/msgpack, application/json\r\n" : "",
+                         cond);
+        if (n <= 0 || n >= (int)sizeof(req) || wifiClient.write((const uint8_t*)req, n) != (size_t)n) {
+          fetchFail(FE_SEND);
+          break;
+        }
+        if (fx.reused) apiConnReused++;
+        else apiConnOpened++;
+        fx.sentUs = micros();
+        fx.state = FS_HEADERS;
+        break;
+      }
+
+      case FS_HEADERS:
+      case FS_BODY:
+        fetchRead();
+        if (fx.state == FS_HEADERS || fx.state == FS_BODY) {
+          if (wifiClient.available() <= 0) return;
+        }
+        break;
+
+      case FS_COMMIT:
+        fetchCommit();
+        break;
+    }
+  } while (millis() - start < FETCH_SLICE_MS);
+}
 
-  char url[220];
-  snprintf(url, sizeof(url), "%s/price?symbol=%s", cfg.apiBase, h.symbol);
+static void streamFail(bool unsupported) {
+  uint32_t now = millis();
+  if (st.state == SS_EVENTS) {
+    for (uint8_t i = 0; i < 3; i++) schedPrice[i].due = now;
+    frameInvalidate(W_COUNTDOWN);
+  }
 
-  HTTPClient http;
-  http.setTimeout(5000);
-  http.setReuse(false);
+  dialAbort(st.dial);
+  streamClient.stop();
+  streamUp = false;
+  if (st.fails < 16) st.fails++;
+
+  uint32_t wait = STREAM_UNSUPPORTED_MS;
+  if (!unsupported) {
+    wait = STREAM_RETRY_MIN_MS;
+    for (uint8_t i = 1; i < st.fails && wait < STREAM_RETRY_MAX_MS; i++) wait *= 2;
+    if (wait > STREAM_RETRY_MAX_MS) wait = STREAM_RETRY_MAX_MS;
+    wait += (uint32_t)random((long)(wait / 4) + 1);
+  }
+  st.state = SS_WAIT;
+  st.retryAt = now + wait;
+}
 
-  if (!http.begin(wifiClient, url)) return false;
-  int code = http.GET();
-  if (code != 200) { http.end(); return false; }
+static void streamResolve() {
+  if (!WiFi.isConnected() || !apiReady() || !parseApiBase(st.api)) { streamFail(false); return; }
+  NetPoll r = dnsPoll(st.api.host, st.ip);
+  if (r == NET_PENDING) return;
+  if (r == NET_FAILED || !dialStart(st.dial, st.ip, st.api.port)) { streamFail(false); return; }
+  st.state = SS_CONNECT;
+}
 
-  DynamicJsonDocument doc(256);
-  DeserializationError err = deserializeJson(doc, http.getStream());
-  http.end();
-  if (err) return false;
+static void streamConnect(uint32_t now) {
+  NetPoll r = dialPoll(st.dial, streamClient, FETCH_CONNECT_TIMEOUT_MS);
+  if (r == NET_PENDING) return;
+  if (r == NET_FAILED) { streamFail(false); return; }
+  streamClient.setNoDelay(true);
+  const ApiHost& a = st.api;
+
+  char req[320];
+  int n = snprintf(req, sizeof(req), "GET %s/stream?symbols=", a.prefix);
+  uint8_t count = (currentMode == MODE_SINGLE) ? 1 : 3;
+  for (uint8_t i = 0; i < count && n < (int)sizeof(req); i++) {
+    n += snprintf(req + n, sizeof(req) - n, i ? ",%s" : "%s", slotSymbol(currentMode, i));
+  }
+  if (n < (int)sizeof(req)) {
+    n += snprintf(req + n, sizeof(req) - n,
+                  " HTTP/1.1\r\nHost: %s:%u\r\nUser-Agent: ESP8266\r\nAccept: text/event-stream\r\nCache-Control: no-cache\r\n\r\n",
+                  a.host, (unsigned int)a.port);
+  }
+  if (n >= (int)sizeof(req) || streamClient.write((const uint8_t*)req, n) != (size_t)n) {
+    streamFail(false);
+    return;
+  }
 
-  h.lastPrice = h.price;
-  h.price = doc["price"].as<float>();
-  return true;
+  streamConnects++;
+  st.mode = currentMode;
+  st.state = SS_HEADERS;
+  st.lastByteAt = now;
+  st.status = 0;
+  st.statusSeen = false;
+  st.chunked = false;
+  chunkReset(st.chunk);
+  st.lineLen = 0;
 }
 
-static bool fetchKlines10(const char* symbol) {
-  if (!apiReady()) { kReady = false; return false; }
+static void streamTick(const char* json) {
+  StaticJsonDocument<256> doc;
+  if (deserializeJson(doc, json)) return;
 
-  char url[260];
-  snprintf(url, sizeof(url), "%s/klines?symbol=%s&interval=1h&limit=10", cfg.apiBase, symbol);
+  const char* sym = doc["symbol"];
+  if (!sym || doc["price"].isNull()) return;
+  Dec p = jsonDec(doc["price"]);
 
-  HTTPClient http;
-  http.setTimeout(8000);
-  http.setReuse(false);
+  uint8_t count = (st.mode == MODE_SINGLE) ? 1 : 3;
+  for (uint8_t i = 0; i < count; i++) {
+    if (strcmp(sym, slotSymbol(st.mode, i)) == 0) applyPrice(st.mode, i, p);
+  }
+  streamEvents++;
+}
 
-  if (!http.begin(wifiClient, url)) { kReady = false; return false; }
+static void streamLine() {
+  char* l = st.line;
+  l[st.lineLen] = 0;
 
-  int code = http.GET();
-  if (code != 200) { http.end(); kReady = false; return false; }
+  if (st.state == SS_HEADERS) {
+    if (!st.statusSeen) {
+      st.statusSeen = true;
+      const char* sp = strchr(l, ' ');
+      st.status = (strncmp(l, "HTTP/1.", 7) == 0 && sp) ? atoi(sp + 1) : -1;
+      return;
+    }
+    if (st.lineLen == 0) {
+      if (st.status != 200) {
+        streamFail(st.status == 404 || st.status == 405 || st.status == 501);
+        return;
+      }
+      st.state = SS_EVENTS;
+      st.fails = 0;
+      streamUp = true;
+      return;
+    }
+    if (strncasecmp(l, "Transfer-Encoding:", 18) == 0 && strstr(l, "chunked")) st.chunked = true;
+    return;
+  }
 
-  DynamicJsonDocument doc(8192);
-  DeserializationError err = deserializeJson(doc, http.getStream());
-  http.end();
+  if (st.lineLen == 0 || l[0] == ':') return;
+  if (strncmp(l, "data:", 5) == 0) {
+    l += 5;
+    while (*l == ' ') l++;
+  } else if (l[0] != '{') {
+    return;
+  }
+  streamTick(l);
+}
 
-  if (err) { kReady = false; return false; }
+static void streamRead(uint32_t now) {
+  int avail = streamClient.available();
+  if (avail <= 0) {
+    if (!streamClient.connected() || now - st.lastByteAt > STREAM_IDLE_MS) streamFail(false);
+    return;
+  }
 
-  JsonArray arr = doc.as<JsonArray>();
-  int n = arr.size();
-  if (n <= 0) { kReady = false; return false; }
+  uint8_t buf[128];
+  int n = streamClient.read(buf, avail < (int)sizeof(buf) ? avail : (int)sizeof(buf));
+  if (n <= 0) return;
+  st.lastByteAt = now;
+
+  for (int i = 0; i < n && (st.state == SS_HEADERS || st.state == SS_EVENTS); i++) {
+    char c = (char)buf[i];
+    if (st.state == SS_EVENTS && st.chunked && !chunkFeed(st.chunk, c)) continue;
+    if (c == '\r') continue;
+    if (c == '\n') {
+      streamLine();
+      st.lineLen = 0;
+    } else if (st.lineLen < sizeof(st.line) - 1) {
+      st.line[st.lineLen++] = c;
+    }
+  }
+}
 
-  for (int i = 0; i < KCOUNT; i++) {
-    int idx = (i < n) ? i : (n - 1);
-    kO[i] = arr[idx][1].as<float>();
-    kH[i] = arr[idx][2].as<float>();
-    kL[i] = arr[idx][3].as<float>();
-    kC[i] = arr[idx][4].as<float>();
-    yield();
+static void streamStep(uint32_t now) {
+  if (!cfg.stream) {
+    if (st.state != SS_OFF) streamRestart();
+    return;
   }
 
-  kReady = true;
-  return true;
+  switch (st.state) {
+    case SS_OFF:
+      st.state = SS_WAIT;
+      st.retryAt = now;
+      break;
+    case SS_WAIT:
+      if (breaker.state == BR_CLOSED && (int32_t)(now - st.retryAt) >= 0) {
+        st.state = SS_RESOLVE;
+        streamResolve();
+      }
+      break;
+    case SS_RESOLVE:
+      streamResolve();
+      break;
+    case SS_CONNECT:
+      streamConnect(now);
+      break;
+    case SS_HEADERS:
+    case SS_EVENTS:
+      if (st.mode != currentMode) streamRestart();
+      else streamRead(now);
+      break;
+  }
 }
 
-static void drawSingle() {
-  tft.fillScreen(TFT_BLACK);
+static void eraseSpan(int x, int w, int oldY, int oldH, int newY, int newH) {
+  if (oldH <= 0) return;
+  if (newH <= 0) {
+    lcdFill(x, oldY, w, oldH, TFT_BLACK);
+    return;
+  }
+  if (oldY < newY) lcdFill(x, oldY, w, min(oldY + oldH, newY) - oldY, TFT_BLACK);
+  int l = max(oldY, newY + newH);
+  if (oldY + oldH > l) lcdFill(x, l, w, oldY + oldH - l, TFT_BLACK);
+}
 
-  tft.setTextFont(2);
-  tft.setTextColor(TFT_CYAN, TFT_BLACK);
-  tft.setCursor(6, TITLE_Y);
-  tft.print(singleCoin.symbol);
+static void drawSingle(bool full) {
+  if (full) {
+    panelDirty(vm.header, 0, DIV1_Y, TFT_W, 1);
+    panelDirty(vm.strip, 0, DIV2_Y, TFT_W, 1);
+  }
 
-  drawDivider(DIV1_Y);
+  char iv[8];
+  snprintf(iv, sizeof(iv), " %s", KI_NAMES[kView]);
+  tft.setTextFont(2);
+  cellSet(vm.header, vm.symbol, 6, TITLE_Y, 2, TFT_CYAN, singleCoin.symbol);
+  cellSet(vm.header, vm.interval, 6 + tft.textWidth(singleCoin.symbol), TITLE_Y, 2, TFT_DARKGREY, iv);
+  panelFlush(vm.header);
 
   char pbuf[28];
   formatPrice(pbuf, sizeof(pbuf), singleCoin.price, singleCoin.decimals);
@@ -389,26 +3220,32 @@ static void drawSingle() {
   if (singleCoin.lastPrice >= 0) {
     priceCol = (singleCoin.price >= singleCoin.lastPrice) ? TFT_GREEN : TFT_RED;
   }
-
-  tft.setTextFont(4);
-  tft.setTextColor(priceCol, TFT_BLACK);
-  tft.setCursor(8, PRICE_Y);
-  tft.print(pbuf);
-
-  drawDivider(DIV2_Y);
-
-  if (!kReady) {
-    tft.setTextFont(2);
-    tft.setTextColor(TFT_ORANGE, TFT_BLACK);
-    tft.setCursor(8, CHART_TOP + 10);
-    tft.print("kline not ready");
+  cellSet(vm.strip, vm.price, 8, PRICE_Y, 4, priceCol, pbuf);
+  panelFlush(vm.strip);
+
+  const KTier& kv = kTiers[kView];
+  if (!kv.ready) {
+    if (vm.chart) {
+      lcdFill(0, CHART_TOP, TFT_W, CHART_BOTTOM - CHART_TOP + 1, TFT_BLACK);
+      memset(vm.slots, 0, sizeof(vm.slots));
+      vm.labels[0] = 0;
+      vm.chart = false;
+    }
+    cellSet(vm.notePanel, vm.note, 8, CHART_TOP + 10, 2, TFT_ORANGE, "kline not ready");
+    panelFlush(vm.notePanel);
     return;
   }
+  if (!vm.chart) {
+    cellSet(vm.notePanel, vm.note, 8, CHART_TOP + 10, 2, TFT_ORANGE, "");
+    panelFlush(vm.notePanel);
+    vm.chart = true;
+  }
 
-  float ymin = kL[0], ymax = kH[0];
-  for (int i = 1; i < KCOUNT; i++) {
-    if (kL[i] < ymin) ymin = kL[i];
-    if (kH[i] > ymax) ymax = kH[i];
+  float ymin = kv.l[kv.head], ymax = kv.h[kv.head];
+  for (int i = 1; i < kv.len; i++) {
+    int k = kIdx(kv, i);
+    if (kv.l[k] < ymin) ymin = kv.l[k];
+    if (kv.h[k] > ymax) ymax = kv.h[k];
   }
   float range = ymax - ymin;
   if (range < 0.0001f) range = 1.0f;
@@ -416,9 +3253,8 @@ static void drawSingle() {
   ymax += range * 0.06f;
   range = ymax - ymin;
 
-  tft.fillRect(0, CHART_TOP, TFT_W, CHART_BOTTOM - CHART_TOP, TFT_BLACK);
-
-  int chartH = (CHART_BOTTOM - CHART_TOP);
+  int chartBottom = CHART_BOTTOM - HOUR_LABEL_H;
+  int chartH = (chartBottom - CHART_TOP);
   int slotW = TFT_W / KCOUNT;
   int bodyW = slotW - 6;
   if (bodyW < 4) bodyW = 4;
@@ -427,44 +3263,85 @@ static void drawSingle() {
     float t = (ymax - v) / range;
     int y = CHART_TOP + (int)(t * (float)chartH);
     if (y < CHART_TOP) y = CHART_TOP;
-    if (y > CHART_BOTTOM) y = CHART_BOTTOM;
+    if (y > chartBottom) y = chartBottom;
     return y;
   };
 
+  uint32_t sec = KI_SECONDS[kView];
+  int labelEvery = (sec < 3600) ? 3 : 2;
+  char labels[sizeof(vm.labels)];
+  size_t ln = 0;
+
   for (int i = 0; i < KCOUNT; i++) {
     int xCenter = i * slotW + slotW / 2;
     int xLeft   = xCenter - bodyW / 2;
 
-    int yH = toY(kH[i]);
-    int yL = toY(kL[i]);
-    int yO = toY(kO[i]);
-    int yC = toY(kC[i]);
+    CandleSlot n = {};
+    if (i < kv.len) {
+      int k = kIdx(kv, i);
+      int yH = toY(kv.h[k]);
+      int yL = toY(kv.l[k]);
+      int yO = toY(kv.o[k]);
+      int yC = toY(kv.c[k]);
+
+      n.wickY = yH;
+      n.wickH = (yL - yH) + 1;
+      n.bodyY = min(yO, yC);
+      n.bodyH = max(abs(yO - yC), 2);
+      n.col = (kv.c[k] >= kv.o[k]) ? TFT_GREEN : TFT_RED;
+
+      if ((kv.len - 1 - i) % labelEvery == 0) {
+        time_t lt = (time_t)kv.t[k] + (time_t)cfg.tzMin * 60;
+        if (sec < 3600) ln += snprintf(labels + ln, sizeof(labels) - ln, "%02d:%02d", hour(lt), minute(lt));
+        else if (sec < 86400) ln += snprintf(labels + ln, sizeof(labels) - ln, "%02d", hour(lt));
+        else ln += snprintf(labels + ln, sizeof(labels) - ln, "%02d", day(lt));
+      }
+    }
+    labels[ln++] = '|';
+    labels[ln] = 0;
 
-    uint16_t col = (kC[i] >= kO[i]) ? TFT_GREEN : TFT_RED;
+    CandleSlot& o = vm.slots[i];
+    if (memcmp(&o, &n, sizeof(n)) == 0) continue;
 
-    tft.drawFastVLine(xCenter, yH, (yL - yH) + 1, TFT_LIGHTGREY);
+    eraseSpan(xCenter, 1, o.wickY, o.wickH, n.wickY, n.wickH);
+    eraseSpan(xLeft, bodyW, o.bodyY, o.bodyH, n.bodyY, n.bodyH);
+    if (n.wickH) {
+      lcdVLine(xCenter, n.wickY, n.wickH, TFT_LIGHTGREY);
+      lcdFill(xLeft, n.bodyY, bodyW, n.bodyH, n.col);
+    }
+    o = n;
+    yield();
+  }
 
-    int top = min(yO, yC);
-    int h   = abs(yO - yC);
-    if (h < 2) h = 2;
+  if (strcmp(vm.labels, labels) == 0) return;
+  memcpy(vm.labels, labels, sizeof(vm.labels));
+  lcdFill(0, CHART_BOTTOM - 7, TFT_W, tft.fontHeight(1), TFT_BLACK);
 
-    tft.fillRect(xLeft, top, bodyW, h, col);
-    yield();
+  const char* l = labels;
+  for (int i = 0; i < KCOUNT; i++) {
+    const char* end = strchr(l, '|');
+    int len = end - l;
+    if (len > 0) {
+      char label[6];
+      memcpy(label, l, len);
+      label[len] = 0;
+      int lx = i * slotW + slotW / 2 - len * 3;
+      if (lx < 0) lx = 0;
+      if (lx > TFT_W - len * 6) lx = TFT_W - len * 6;
+      lcdText(lx, CHART_BOTTOM - 7, 1, TFT_DARKGREY, label);
+    }
+    l = end + 1;
   }
 }
 
-static void drawTriple() {
-  tft.fillScreen(TFT_BLACK);
-
+static void drawTriple(bool full) {
   for (int i = 0; i < 3; i++) {
     int y = i * 80;
+    RowView& r = vm.rows[i];
 
-    drawDivider(y + 22);
+    if (full) panelDirty(r.panel, 0, r.panel.divY, TFT_W, 1);
 
-    tft.setTextFont(2);
-    tft.setTextColor(TFT_CYAN, TFT_BLACK);
-    tft.setCursor(6, y + 2);
-    tft.print(tripleCoins[i].symbol);
+    cellSet(r.panel, r.symbol, 6, y + 2, 2, TFT_CYAN, tripleCoins[i].symbol);
 
     char buf[28];
     formatPrice(buf, sizeof(buf), tripleCoins[i].price, tripleCoins[i].decimals);
@@ -474,32 +3351,25 @@ static void drawTriple() {
       col = (tripleCoins[i].price >= tripleCoins[i].lastPrice) ? TFT_GREEN : TFT_RED;
     }
 
-    tft.setTextFont(4);
-    tft.setTextColor(col, TFT_BLACK);
-    tft.setCursor(8, y + 30);
-    tft.print(buf);
+    cellSet(r.panel, r.price, 8, y + 30, 4, col, buf);
 
-    tft.setTextFont(2);
-    tft.setTextColor(TFT_LIGHTGREY, TFT_BLACK);
-    tft.setCursor(190, y + 34);
-    tft.printf("d:%u", (unsigned int)tripleCoins[i].decimals);
+    char dbuf[8];
+    snprintf(dbuf, sizeof(dbuf), "d:%u", (unsigned int)tripleCoins[i].decimals);
+    cellSet(r.panel, r.info, 190, y + 34, 2, TFT_LIGHTGREY, dbuf);
+    panelFlush(r.panel);
 
     yield();
   }
 }
 
-static void drawHoldings() {
-  tft.fillScreen(TFT_BLACK);
-
+static void drawHoldings(bool full) {
   for (int i = 0; i < 3; i++) {
     int y = i * 80;
+    RowView& r = vm.rows[i];
 
-    tft.setTextFont(2);
-    tft.setTextColor(TFT_CYAN, TFT_BLACK);
-    tft.setCursor(4, y + 1);
-    tft.print(holdings[i].symbol);
+    if (full) panelDirty(r.panel, 0, r.panel.divY, TFT_W, 1);
 
-    drawDivider(y + 18);
+    cellSet(r.panel, r.symbol, 4, y + 1, 2, TFT_CYAN, holdings[i].symbol);
 
     char priceBuf[28];
     formatPrice(priceBuf, sizeof(priceBuf), holdings[i].price, holdings[i].decimals);
@@ -509,46 +3379,86 @@ static void drawHoldings() {
       priceCol = (holdings[i].price >= holdings[i].lastPrice) ? TFT_GREEN : TFT_RED;
     }
 
-    tft.setTextFont(4);
-    tft.setTextColor(priceCol, TFT_BLACK);
-    tft.setCursor(4, y + 22);
-    tft.print(priceBuf);
+    cellSet(r.panel, r.price, 4, y + 22, 4, priceCol, priceBuf);
 
-    float costTotal = holdings[i].buyPrice * holdings[i].amount;
-    float currentTotal = holdings[i].price * holdings[i].amount;
-    float plUsdt = currentTotal - costTotal;
-    float plPercent = (holdings[i].buyPrice > 0) ? (plUsdt / costTotal * 100.0f) : 0;
+    Dec costTotal = decMul(holdings[i].buyPrice, holdings[i].amount);
+    Dec currentTotal = decMul(holdings[i].price, holdings[i].amount);
+    Dec plUsdt = currentTotal - costTotal;
+    Dec plPercent = (costTotal > 0) ? decDiv(plUsdt * 100, costTotal) : 0;
 
     uint16_t plCol = (plUsdt >= 0) ? TFT_GREEN : TFT_RED;
 
-    tft.setTextFont(4);
-    tft.setTextColor(plCol, TFT_BLACK);
     char plBuf[24];
     formatPL(plBuf, sizeof(plBuf), plUsdt);
+    cellSet(r.panel, r.pl, 236, y + 22, 4, plCol, plBuf, true);
 
-    uint16_t w = tft.textWidth(plBuf);
-    tft.setCursor(236 - w, y + 22);
-    tft.print(plBuf);
-
-    tft.setTextFont(2);
-    tft.setTextColor(TFT_LIGHTGREY, TFT_BLACK);
-    tft.setCursor(4, y + 54);
     char infoBuf[48];
-    snprintf(infoBuf, sizeof(infoBuf), "%.3f@$%.2f", holdings[i].amount, holdings[i].buyPrice);
-    tft.print(infoBuf);
+    size_t n = decFormat(infoBuf, sizeof(infoBuf) - 1, holdings[i].amount, 3);
+    infoBuf[n++] = '@';
+    formatPrice(infoBuf + n, sizeof(infoBuf) - n, holdings[i].buyPrice, 2);
+    cellSet(r.panel, r.info, 4, y + 54, 2, TFT_LIGHTGREY, infoBuf);
 
-    tft.setTextFont(2);
-    tft.setTextColor(plCol, TFT_BLACK);
     char pctBuf[16];
     formatPercent(pctBuf, sizeof(pctBuf), plPercent);
-    w = tft.textWidth(pctBuf);
-    tft.setCursor(236 - w, y + 54);
-    tft.print(pctBuf);
+    cellSet(r.panel, r.pct, 236, y + 54, 2, plCol, pctBuf, true);
+    panelFlush(r.panel);
 
     yield();
   }
 }
 
+static bool drawView() {
+  bool full = viewBegin();
+  if (currentMode == MODE_SINGLE) drawSingle(full);
+  else if (currentMode == MODE_TRIPLE) drawTriple(full);
+  else drawHoldings(full);
+  viewEnd(full);
+  return full;
+}
+
+static uint32_t countdownNext(uint32_t now, uint32_t remainMs) {
+  if (remainMs > 99999) return now + min(remainMs - 99999, (uint32_t)1000);
+  if (remainMs == 0) return now + 1000;
+  return now + remainMs % 1000 + 1;
+}
+
+static void frameRun(uint32_t now) {
+  if (now - fs.windowAt >= IDLE_WINDOW_MS) {
+    uint32_t us = (now - fs.windowAt) * 1000UL;
+    fs.idlePct = (fs.idleUs >= us) ? 100 : (uint8_t)(fs.idleUs * 100ULL / us);
+    fs.windowAt = now;
+    fs.idleUs = 0;
+  }
+  if (now - fs.lastAt < FRAME_MS) return;
+
+  if ((int32_t)(now - fs.dueAt[W_COUNTDOWN]) >= 0) fs.dirty |= 1 << W_COUNTDOWN;
+  uint8_t run = fs.dirty;
+  bool viewOk = (fs.urgent & (1 << W_VIEW)) || (!cycleActive && now - lastDraw >= DRAW_MIN_MS);
+  if (!viewOk) run &= ~(1 << W_VIEW);
+  if (!run) return;
+
+  fs.dirty &= ~run;
+  fs.urgent &= ~run;
+  fs.lastAt = now;
+  uint32_t t = micros();
+
+  if (run & (1 << W_VIEW)) {
+    lastDraw = now;
+    if (drawView()) run |= 1 << W_COUNTDOWN;
+    latRecord(LAT_DRAW, micros() - t);
+  }
+  if (run & (1 << W_COUNTDOWN)) {
+    uint32_t remain = schedRemaining(now);
+    drawCountdown(remain);
+    fs.dueAt[W_COUNTDOWN] = countdownNext(now, remain);
+  }
+
+  fs.lastUs = micros() - t;
+  if (fs.lastUs > fs.maxUs) fs.maxUs = fs.lastUs;
+  fs.sumUs += fs.lastUs;
+  fs.frames++;
+}
+
 static const char HTML[] PROGMEM = R"rawliteral(
 <!doctype html>
 <html>
@@ -582,6 +3492,14 @@ label{min-width:64px;}
     <label>Webhook</label>
     <input id="wh" class="code" placeholder="https://open.feishu.cn/.../hook/xxxx" />
   </div>
+  <div class="row" style="margin-top:8px;">
+    <label>Wire</label>
+    <select id="mp"><option value="0">JSON</option><option value="1">MessagePack</option></select>
+  </div>
+  <div class="row" style="margin-top:8px;">
+    <label>Prices</label>
+    <select id="stm"><option value="0">Poll</option><option value="1">Stream (SSE)</option></select>
+  </div>
   <div class="row" style="margin-top:10px;">
     <button onclick="saveCfg()">Save</button>
     <button onclick="loadCfg()">Reload</button>
@@ -609,6 +3527,7 @@ label{min-width:64px;}
   <button onclick="quickSingle('SOLUSDT')">SOL</button>
   <button onclick="quickSingle('BNBUSDT')">BNB</button>
   <button onclick="quickSingle('DOGEUSDT')">DOGE</button>
+  <button onclick="quickSingle('next')">Next</button>
 </div>
 <div class="row" style="margin-top:10px;">
   <span>Decimals:</span>
@@ -617,6 +3536,13 @@ label{min-width:64px;}
   </select>
   <button onclick="setSingleDec()">Apply</button>
 </div>
+<div class="row" style="margin-top:10px;">
+  <span>Interval:</span>
+  <select id="si">
+    <option>1m</option><option>5m</option><option>15m</option><option selected>1h</option><option>4h</option><option>1d</option>
+  </select>
+  <button onclick="setInterval_()">Apply</button>
+</div>
 </div>
 
 <div class="card">
@@ -666,7 +3592,29 @@ label{min-width:64px;}
 <p><small>Buy 是买入均价(USDT)，Amt 是持仓数量。</small></p>
 </div>
 
-<p><small>屏幕右上角 T-xx 是下一次刷新倒计时（15 秒一轮）。</small></p>
+<div class="card">
+<h2>Refresh</h2>
+<div class="row">
+  <label>Price s</label><input id="rp" class="num" value="15">
+  <label>Kline s</label><input id="rk" class="num" value="60">
+  <label>Fast s</label><input id="rf" class="num" value="5">
+  <label>TZ h</label><input id="rt" class="num" value="8">
+</div>
+<div class="row" style="margin-top:8px;">
+  <label>Rotation</label><input id="rr" class="code" placeholder="BTCUSDT,ETHUSDT,SOLUSDT">
+</div>
+<div class="row" style="margin-top:8px;">
+  <label>Prefetch/h</label><input id="rpr" class="num" value="120">
+  <label>KB/h</label><input id="rpb" class="num" value="256">
+</div>
+<div class="row" style="margin-top:10px;">
+  <button onclick="applySched()">Apply</button>
+</div>
+<p><small>Fast 是行情波动大时的价格刷新间隔；请求失败会自动退避（最长 5 分钟）。</small></p>
+<p><small>空闲时预取其它模式和 Rotation 里下一个币的数据，每小时最多 Prefetch/h 次、KB/h 流量；填 0 关闭。</small></p>
+</div>
+
+<p><small>屏幕右上角 T-xx 是下一次刷新倒计时。</small></p>
 
 <script>
 function apiCall(u){ fetch(u).catch(console.error); }
@@ -683,12 +3631,24 @@ async function loadCfg(){
   const j = await r.json();
   api.value = j.api || "";
   wh.value = j.webhook || "";
+  mp.value = j.msgpack ? "1" : "0";
+  stm.value = j.stream ? "1" : "0";
+  if (j.price_s) rp.value = j.price_s;
+  if (j.kline_s) rk.value = j.kline_s;
+  if (j.fast_s) rf.value = j.fast_s;
+  if (j.tz_min !== undefined) rt.value = j.tz_min / 60;
+  if (j.interval) si.value = j.interval;
+  rr.value = j.rotation || "";
+  if (j.prefetch_req !== undefined) rpr.value = j.prefetch_req;
+  if (j.prefetch_kb !== undefined) rpb.value = j.prefetch_kb;
 }
 
 async function saveCfg(){
   const u = "/cfg?api=" + encodeURIComponent(api.value.trim())
-          + "&wh=" + encodeURIComponent(wh.value.trim());
-  await fetch(u);
+          + "&wh=" + encodeURIComponent(wh.value.trim())
+          + "&mp=" + mp.value
+          + "&st=" + stm.value;
+  await fetch(u, {method: "POST"});
   await loadCfg();
 }
 
@@ -700,6 +3660,7 @@ function setSingle(){
 }
 function quickSingle(s){ apiCall("/single?sym="+encodeURIComponent(s)); }
 function setSingleDec(){ apiCall("/singleDec?d="+encodeURIComponent(sd.value)); }
+function setInterval_(){ apiCall("/interval?i="+encodeURIComponent(si.value)); }
 
 function applyTriple(){
   const c0 = normSym(t0.value), c1 = normSym(t1.value), c2 = normSym(t2.value);
@@ -718,6 +3679,13 @@ function applyHoldings(){
       +"&d0="+h0d.value+"&d1="+h1d.value+"&d2="+h2d.value);
 }
 
+function applySched(){
+  const tz = Math.round(parseFloat(rt.value) * 60);
+  apiCall("/sched?p="+encodeURIComponent(rp.value)+"&k="+encodeURIComponent(rk.value)+"&f="+encodeURIComponent(rf.value)
+      +"&r="+encodeURIComponent(rr.value)+"&pr="+encodeURIComponent(rpr.value)+"&pb="+encodeURIComponent(rpb.value)
+      +(isFinite(tz) ? "&tz="+tz : ""));
+}
+
 loadCfg().catch(console.error);
 </script>
 </body>
@@ -729,9 +3697,19 @@ static void handleRoot() {
 }
 
 static void handleCfgGet() {
-  StaticJsonDocument<512> out;
+  StaticJsonDocument<768> out;
   out["api"] = String(cfg.apiBase);
   out["webhook"] = String(cfg.webhook);
+  out["msgpack"] = (cfg.wire == WIRE_MSGPACK);
+  out["price_s"] = cfg.priceSec;
+  out["kline_s"] = cfg.klineSec;
+  out["fast_s"] = cfg.fastSec;
+  out["stream"] = (cfg.stream != 0);
+  out["rotation"] = String(cfg.rotation);
+  out["prefetch_req"] = cfg.prefetchReq;
+  out["prefetch_kb"] = cfg.prefetchKB;
+  out["interval"] = KI_NAMES[cfg.interval];
+  out["tz_min"] = cfg.tzMin;
   String body;
   serializeJson(out, body);
   server.send(200, "application/json; charset=utf-8", body);
@@ -749,124 +3727,336 @@ static void handleCfgSet() {
   if (wh.length() >= 0) {
     wh.toCharArray(cfg.webhook, sizeof(cfg.webhook));
   }
+  if (server.hasArg("mp")) {
+    cfg.wire = (server.arg("mp").toInt() == 1) ? WIRE_MSGPACK : WIRE_JSON;
+  }
+  if (server.hasArg("st")) {
+    cfg.stream = (server.arg("st").toInt() == 1) ? 1 : 0;
+  }
 
   cfgSave();
+  apiConnReset();
+  breakerReset();
+  streamRestart();
+  pricesBatchOk = true;
   server.send(200, "text/plain", "OK");
 }
 
-static void handleMode() {
-  String m = server.arg("m");
-  if (m == "single") currentMode = MODE_SINGLE;
-  if (m == "triple") currentMode = MODE_TRIPLE;
-  if (m == "holdings") currentMode = MODE_HOLDINGS;
-  server.send(200, "text/plain", "OK");
+enum CmdKind : uint8_t { CMD_MODE, CMD_SINGLE, CMD_SINGLE_DEC, CMD_TRIPLE, CMD_HOLDINGS, CMD_INTERVAL };
+enum CmdState : uint8_t { CMD_UNKNOWN, CMD_QUEUED, CMD_APPLIED, CMD_DONE };
+static const char* const CMD_STATE_NAMES[] = {"unknown", "queued", "applied", "done"};
+
+struct Command {
+  uint16_t id;
+  CmdKind kind;
+  Mode mode;
+  char sym[3][12];
+  Dec buy[3];
+  Dec amount[3];
+  uint8_t dec[3];
+  uint8_t interval;
+};
+
+struct CmdStatus {
+  uint16_t id;
+  CmdState state;
+};
+
+static const int CMD_QUEUE_LEN = 4;
+static const int CMD_LOG_LEN = 8;
+static Command cmdQueue[CMD_QUEUE_LEN];
+static uint8_t cmdHead = 0;
+static uint8_t cmdCount = 0;
+static uint16_t cmdNextId = 1;
+static uint16_t cmdAwait = 0;
+static CmdStatus cmdLog[CMD_LOG_LEN];
+
+static void cmdSetState(uint16_t id, CmdState state) {
+  CmdStatus& s = cmdLog[id % CMD_LOG_LEN];
+  s.id = id;
+  s.state = state;
 }
 
-static void handleSingle() {
-  String s = server.arg("sym");
-  if (s.length() < 2) { server.send(400, "text/plain", "BAD sym"); return; }
+static Command* cmdNew(CmdKind kind) {
+  if (cmdCount >= CMD_QUEUE_LEN) {
+    server.send(503, "text/plain", "BUSY");
+    return nullptr;
+  }
+  Command* c = &cmdQueue[(cmdHead + cmdCount) % CMD_QUEUE_LEN];
+  memset(c, 0, sizeof(*c));
+  c->kind = kind;
+  return c;
+}
 
-  normalizeSymbol(s);
-  setCoinSymbol(singleCoin, s);
-  kReady = false;
+static void cmdSubmit(Command* c) {
+  c->id = cmdNextId++;
+  if (cmdNextId == 0) cmdNextId = 1;
+  cmdCount++;
+  cmdSetState(c->id, CMD_QUEUED);
+
+  char body[24];
+  snprintf(body, sizeof(body), "{\"id\":%u}", (unsigned int)c->id);
+  server.send(202, "application/json", body);
+}
 
-  currentMode = MODE_SINGLE;
-  fetchPrice(singleCoin);
-  fetchKlines10(singleCoin.symbol);
-  drawSingle();
+static void cmdApply(const Command& c) {
+  switch (c.kind) {
+    case CMD_MODE:
+      currentMode = c.mode;
+      break;
+
+    case CMD_SINGLE:
+      if (strcmp(c.sym[0], singleCoin.symbol) != 0) {
+        klineStash(singleCoin.symbol);
+        setCoinSymbol(singleCoin, String(c.sym[0]));
+        klineRestore(singleCoin.symbol);
+      }
+      currentMode = MODE_SINGLE;
+      break;
+
+    case CMD_SINGLE_DEC:
+      singleCoin.decimals = c.dec[0];
+      if (currentMode == MODE_SINGLE) {
+        frameInvalidate(W_VIEW, true);
+      }
+      return;
+
+    case CMD_INTERVAL:
+      kView = c.interval;
+      cfg.interval = c.interval;
+      cfgSave();
+      if (currentMode == MODE_SINGLE) {
+        frameInvalidate(W_VIEW, true);
+      }
+      return;
+
+    case CMD_TRIPLE:
+      for (uint8_t i = 0; i < 3; i++) {
+        setCoinSymbol(tripleCoins[i], String(c.sym[i]));
+        tripleCoins[i].decimals = c.dec[i];
+      }
+      currentMode = MODE_TRIPLE;
+      break;
+
+    case CMD_HOLDINGS:
+      for (uint8_t i = 0; i < 3; i++) {
+        setHoldingSymbol(holdings[i], String(c.sym[i]));
+        holdings[i].buyPrice = c.buy[i];
+        holdings[i].amount = c.amount[i];
+        holdings[i].decimals = c.dec[i];
+      }
+      currentMode = MODE_HOLDINGS;
+      break;
+  }
 
-  server.send(200, "text/plain", "OK");
+  frameInvalidate(W_VIEW, true);
+  schedReset();
 }
 
-static void handleSingleDec() {
-  int d = server.arg("d").toInt();
+static void cmdRun() {
+  while (cmdCount > 0) {
+    const Command& c = cmdQueue[cmdHead];
+    cmdApply(c);
+    if (c.kind == CMD_SINGLE_DEC || (c.kind == CMD_INTERVAL && kTiers[kView].ready && !kTiers[kView].stale)) {
+      cmdSetState(c.id, CMD_DONE);
+    } else {
+      if (cmdAwait) cmdSetState(cmdAwait, CMD_DONE);
+      cmdSetState(c.id, CMD_APPLIED);
+      cmdAwait = c.id;
+    }
+    cmdHead = (cmdHead + 1) % CMD_QUEUE_LEN;
+    cmdCount--;
+  }
+}
+
+static void cmdTrack(uint32_t now) {
+  if (!cmdAwait || cycleActive || breaker.state != BR_CLOSED || schedRemaining(now) == 0) return;
+  cmdSetState(cmdAwait, CMD_DONE);
+  cmdAwait = 0;
+}
+
+static uint8_t argDecimals(const char* name) {
+  int d = server.arg(name).toInt();
   if (d < 0) d = 0;
   if (d > 6) d = 6;
-  singleCoin.decimals = (uint8_t)d;
-
-  if (currentMode == MODE_SINGLE) drawSingle();
-  server.send(200, "text/plain", "OK");
+  return (uint8_t)d;
 }
 
-static void handleTripleConfig() {
-  String c0 = server.arg("c0");
-  String c1 = server.arg("c1");
-  String c2 = server.arg("c2");
+static Dec argDec(const char* name) {
+  Dec v = 0;
+  decParse(server.arg(name).c_str(), v);
+  return v;
+}
 
-  if (c0.length() < 2 || c1.length() < 2 || c2.length() < 2) {
-    server.send(400, "text/plain", "BAD c0/c1/c2");
-    return;
+static bool argSymbols(char sym[3][12], const char* const names[3]) {
+  for (uint8_t i = 0; i < 3; i++) {
+    String s = server.arg(names[i]);
+    if (s.length() < 2) return false;
+    normalizeSymbol(s);
+    s.toCharArray(sym[i], sizeof(sym[i]));
   }
+  return true;
+}
+
+static void handleMode() {
+  String m = server.arg("m");
+  Mode mode;
+  if (m == "single") mode = MODE_SINGLE;
+  else if (m == "triple") mode = MODE_TRIPLE;
+  else if (m == "holdings") mode = MODE_HOLDINGS;
+  else { server.send(400, "text/plain", "BAD m"); return; }
+
+  Command* c = cmdNew(CMD_MODE);
+  if (!c) return;
+  c->mode = mode;
+  cmdSubmit(c);
+}
 
-  normalizeSymbol(c0);
-  normalizeSymbol(c1);
-  normalizeSymbol(c2);
+static void handleSingle() {
+  String s = server.arg("sym");
+  if (s.length() < 2) { server.send(400, "text/plain", "BAD sym"); return; }
 
-  setCoinSymbol(tripleCoins[0], c0);
-  setCoinSymbol(tripleCoins[1], c1);
-  setCoinSymbol(tripleCoins[2], c2);
+  char next[12];
+  bool rotate = s.equalsIgnoreCase("next");
+  if (rotate && !rotationNext(singleCoin.symbol, next, sizeof(next))) {
+    server.send(400, "text/plain", "NO rotation");
+    return;
+  }
 
-  int d0 = server.arg("d0").toInt();
-  int d1 = server.arg("d1").toInt();
-  int d2 = server.arg("d2").toInt();
+  Command* c = cmdNew(CMD_SINGLE);
+  if (!c) return;
+  if (rotate) s = next;
+  normalizeSymbol(s);
+  s.toCharArray(c->sym[0], sizeof(c->sym[0]));
+  cmdSubmit(c);
+}
 
-  if (d0 < 0) d0 = 0; if (d0 > 6) d0 = 6;
-  if (d1 < 0) d1 = 0; if (d1 > 6) d1 = 6;
-  if (d2 < 0) d2 = 0; if (d2 > 6) d2 = 6;
+static void handleSingleDec() {
+  Command* c = cmdNew(CMD_SINGLE_DEC);
+  if (!c) return;
+  c->dec[0] = argDecimals("d");
+  cmdSubmit(c);
+}
 
-  tripleCoins[0].decimals = (uint8_t)d0;
-  tripleCoins[1].decimals = (uint8_t)d1;
-  tripleCoins[2].decimals = (uint8_t)d2;
+static void handleTripleConfig() {
+  static const char* const SYMS[3] = {"c0", "c1", "c2"};
+  static const char* const DECS[3] = {"d0", "d1", "d2"};
 
-  currentMode = MODE_TRIPLE;
-  for (int i = 0; i < 3; i++) fetchPrice(tripleCoins[i]);
-  drawTriple();
+  char sym[3][12];
+  if (!argSymbols(sym, SYMS)) {
+    server.send(400, "text/plain", "BAD c0/c1/c2");
+    return;
+  }
 
-  server.send(200, "text/plain", "OK");
+  Command* c = cmdNew(CMD_TRIPLE);
+  if (!c) return;
+  memcpy(c->sym, sym, sizeof(c->sym));
+  for (uint8_t i = 0; i < 3; i++) c->dec[i] = argDecimals(DECS[i]);
+  cmdSubmit(c);
 }
 
 static void handleHoldingsConfig() {
-  String s0 = server.arg("s0");
-  String s1 = server.arg("s1");
-  String s2 = server.arg("s2");
+  static const char* const SYMS[3] = {"s0", "s1", "s2"};
+  static const char* const BUYS[3] = {"b0", "b1", "b2"};
+  static const char* const AMTS[3] = {"a0", "a1", "a2"};
+  static const char* const DECS[3] = {"d0", "d1", "d2"};
 
-  if (s0.length() < 2 || s1.length() < 2 || s2.length() < 2) {
+  char sym[3][12];
+  if (!argSymbols(sym, SYMS)) {
     server.send(400, "text/plain", "BAD symbols");
     return;
   }
 
-  normalizeSymbol(s0);
-  normalizeSymbol(s1);
-  normalizeSymbol(s2);
-
-  setHoldingSymbol(holdings[0], s0);
-  setHoldingSymbol(holdings[1], s1);
-  setHoldingSymbol(holdings[2], s2);
+  Command* c = cmdNew(CMD_HOLDINGS);
+  if (!c) return;
+  memcpy(c->sym, sym, sizeof(c->sym));
+  for (uint8_t i = 0; i < 3; i++) {
+    c->buy[i] = argDec(BUYS[i]);
+    c->amount[i] = argDec(AMTS[i]);
+    c->dec[i] = argDecimals(DECS[i]);
+  }
+  cmdSubmit(c);
+}
 
-  holdings[0].buyPrice = server.arg("b0").toFloat();
-  holdings[1].buyPrice = server.arg("b1").toFloat();
-  holdings[2].buyPrice = server.arg("b2").toFloat();
+static void handleInterval() {
+  String s = server.arg("i");
+  uint8_t i = 0;
+  while (i < KI_COUNT && s != KI_NAMES[i]) i++;
+  if (i == KI_COUNT) { server.send(400, "text/plain", "BAD interval"); return; }
 
-  holdings[0].amount = server.arg("a0").toFloat();
-  holdings[1].amount = server.arg("a1").toFloat();
-  holdings[2].amount = server.arg("a2").toFloat();
+  Command* c = cmdNew(CMD_INTERVAL);
+  if (!c) return;
+  c->interval = i;
+  cmdSubmit(c);
+}
 
-  int d0 = server.arg("d0").toInt();
-  int d1 = server.arg("d1").toInt();
-  int d2 = server.arg("d2").toInt();
+static void handleStatus() {
+  uint16_t id = (uint16_t)server.arg("id").toInt();
+  const CmdStatus& s = cmdLog[id % CMD_LOG_LEN];
+  CmdState state = (id != 0 && s.id == id) ? s.state : CMD_UNKNOWN;
 
-  if (d0 < 0) d0 = 0; if (d0 > 6) d0 = 6;
-  if (d1 < 0) d1 = 0; if (d1 > 6) d1 = 6;
-  if (d2 < 0) d2 = 0; if (d2 > 6) d2 = 6;
+  char body[48];
+  snprintf(body, sizeof(body), "{\"id\":%u,\"state\":\"%s\"}", (unsigned int)id, CMD_STATE_NAMES[state]);
+  server.send(state == CMD_UNKNOWN ? 404 : 200, "application/json", body);
+}
 
-  holdings[0].decimals = (uint8_t)d0;
-  holdings[1].decimals = (uint8_t)d1;
-  holdings[2].decimals = (uint8_t)d2;
+static void handleSched() {
+  int p = server.arg("p").toInt();
+  int k = server.arg("k").toInt();
+  int f = server.arg("f").toInt();
 
-  currentMode = MODE_HOLDINGS;
-  for (int i = 0; i < 3; i++) fetchHoldingPrice(holdings[i]);
-  drawHoldings();
+  if (p > 0) {
+    if (p < 3) p = 3;
+    if (p > 3600) p = 3600;
+    cfg.priceSec = (uint16_t)p;
+  }
+  if (k > 0) {
+    if (k < 10) k = 10;
+    if (k > 3600) k = 3600;
+    cfg.klineSec = (uint16_t)k;
+  }
+  if (f > 0) {
+    if (f < 2) f = 2;
+    if (f > cfg.priceSec) f = cfg.priceSec;
+    cfg.fastSec = (uint16_t)f;
+  }
+  if (server.hasArg("r")) {
+    String list = server.arg("r");
+    String rot;
+    int from = 0;
+    while (from <= (int)list.length()) {
+      int comma = list.indexOf(',', from);
+      if (comma < 0) comma = list.length();
+      String sym = list.substring(from, comma);
+      sym.trim();
+      from = comma + 1;
+      if (sym.length() < 2) continue;
+      normalizeSymbol(sym);
+      if (rot.length() + sym.length() + 1 >= sizeof(cfg.rotation)) break;
+      if (rot.length()) rot += ',';
+      rot += sym;
+    }
+    rot.toCharArray(cfg.rotation, sizeof(cfg.rotation));
+  }
+  if (server.hasArg("pr")) {
+    int pr = server.arg("pr").toInt();
+    cfg.prefetchReq = (uint16_t)(pr < 0 ? 0 : pr > 3600 ? 3600 : pr);
+  }
+  if (server.hasArg("pb")) {
+    int pb = server.arg("pb").toInt();
+    cfg.prefetchKB = (uint16_t)(pb < 0 ? 0 : pb > 4096 ? 4096 : pb);
+  }
+  if (server.hasArg("tz")) {
+    int tz = server.arg("tz").toInt();
+    tz = tz < -720 ? -720 : tz > 840 ? 840 : tz;
+    tz = (tz + (tz < 0 ? -7 : 7)) / 15 * 15;
+    if (tz != cfg.tzMin) frameInvalidate(W_VIEW, true);
+    cfg.tzMin = (int16_t)tz;
+  }
 
+  cfgSanitize();
+  cfgSave();
+  schedReset();
   server.send(200, "text/plain", "OK");
 }
 
@@ -875,23 +4065,33 @@ void setup() {
   delay(50);
 
   cfgLoad();
+  kView = cfg.interval;
 
   tft.init();
   tft.setRotation(0);
   pinMode(TFT_BL, OUTPUT);
   digitalWrite(TFT_BL, LOW);
   tft.fillScreen(TFT_BLACK);
+  spritePoolInit();
+  atlasBuild();
 
   WiFiManager wm;
   wm.setConnectTimeout(15);
   wm.autoConnect("BTC_Display");
 
+  configTime(0, 0, "pool.ntp.org", "time.nist.gov");
+  setSyncProvider(sntpTime);
+  setSyncInterval(NTP_RETRY_S);
+
   server.on("/", handleRoot);
   server.on("/mode", handleMode);
   server.on("/single", handleSingle);
   server.on("/singleDec", handleSingleDec);
+  server.on("/interval", handleInterval);
   server.on("/triple", handleTripleConfig);
   server.on("/holdings", handleHoldingsConfig);
+  server.on("/sched", handleSched);
+  server.on("/status", handleStatus);
 
   server.on("/cfg", HTTP_GET, handleCfgGet);
   server.on("/cfg", HTTP_POST, handleCfgSet);
@@ -899,43 +4099,40 @@ void setup() {
 
   server.on("/push", handlePushSys);
   server.on("/sys", handleSysJson);
+  server.on("/metrics", handleMetrics);
 
   server.begin();
 
-  lastFetch = millis();
   lastSysPush = millis();
 
-  fetchPrice(singleCoin);
-  fetchKlines10(singleCoin.symbol);
-  drawSingle();
+  schedReset();
 }
 
 void loop() {
+  heapMark();
   server.handleClient();
+  cmdRun();
+
+  bool up = WiFi.isConnected();
+  if (up && !wifiUp) dnsFlush();
+  wifiUp = up;
+  clockPoll();
 
   uint32_t now = millis();
-  drawCountdown(now);
 
   if (SYS_PUSH_MS > 0 && (now - lastSysPush >= SYS_PUSH_MS)) {
     lastSysPush = now;
     postFeishuText(buildSysReportText());
   }
 
-  if (now - lastFetch >= REFRESH_MS) {
-    lastFetch = now;
+  schedPoll(now);
+  fetchStep();
+  streamStep(now);
 
-    if (currentMode == MODE_SINGLE) {
-      fetchPrice(singleCoin);
-      fetchKlines10(singleCoin.symbol);
-      drawSingle();
-    } else if (currentMode == MODE_TRIPLE) {
-      for (int i = 0; i < 3; i++) fetchPrice(tripleCoins[i]);
-      drawTriple();
-    } else {
-      for (int i = 0; i < 3; i++) fetchHoldingPrice(holdings[i]);
-      drawHoldings();
-    }
-  }
+  frameRun(millis());
+  cmdTrack(now);
 
+  uint32_t t = micros();
   delay(2);
+  fs.idleUs += micros() - t;
 }
\ No newline at end of file
@@ -0,0 +1,153 @@
+#include <unity.h>
+#include <stdio.h>
+#define ARDUINOJSON_USE_DOUBLE 1
+#include <ArduinoJson.h>
+#include "Dec.h"
+
+#ifdef ARDUINO
+#include <Arduino.h>
+static uint32_t benchNow() { return ESP.getCycleCount(); }
+static const char* BENCH_UNIT = "cycles";
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+static uint32_t benchNow() { return (uint32_t)__rdtsc(); }
+static const char* BENCH_UNIT = "cycles";
+#else
+#include <chrono>
+static uint32_t benchNow() {
+  return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+static const char* BENCH_UNIT = "ns";
+#endif
+
+static const uint32_t BENCH_CALLS = 2000;
+static const uint8_t BENCH_INPUTS = 4;
+static const char* PRICE_TEXT[BENCH_INPUTS] = { "104523.45000000", "0.00001234", "3456.78900000", "1.00020000" };
+static const uint8_t PRICE_DECIMALS[BENCH_INPUTS] = { 2, 8, 2, 4 };
+static const char* PRICE_BODY[BENCH_INPUTS] = {
+  "{\"symbol\":\"BTCUSDT\",\"price\":\"104523.45000000\"}",
+  "{\"symbol\":\"PEPEUSDT\",\"price\":\"0.00001234\"}",
+  "{\"symbol\":\"ETHUSDT\",\"price\":\"3456.78900000\"}",
+  "{\"symbol\":\"USDCUSDT\",\"price\":\"1.00020000\"}"
+};
+static volatile uint32_t sink;
+
+void setUp() {}
+void tearDown() {}
+
+// The float/snprintf path the display used before the fixed-point rewrite.
+static void floatFormatPrice(char* out, size_t len, float v, uint8_t d) {
+  if (d > 6) d = 6;
+  char fmt[12];
+  snprintf(fmt, sizeof(fmt), "$%%.%df", d);
+  snprintf(out, len, fmt, v);
+}
+
+static void floatFormatPL(char* out, size_t len, float v) {
+  if (v >= 0) snprintf(out, len, "+$%.2f", v);
+  else snprintf(out, len, "-$%.2f", -v);
+}
+
+static void floatFormatPercent(char* out, size_t len, float pct) {
+  if (pct >= 0) snprintf(out, len, "+%.2f%%", pct);
+  else snprintf(out, len, "%.2f%%", pct);
+}
+
+template <typename F>
+static uint32_t benchRun(F f) {
+  uint32_t t0 = benchNow();
+  for (uint32_t i = 0; i < BENCH_CALLS; i++) f(i % BENCH_INPUTS);
+  return (benchNow() - t0) / BENCH_CALLS;
+}
+
+static void benchReport(const char* name, uint32_t floatPer, uint32_t decPer) {
+  char line[96];
+  snprintf(line, sizeof(line), "%-10s float %6u  dec %6u  %s/call",
+           name, (unsigned)floatPer, (unsigned)decPer, BENCH_UNIT);
+  TEST_MESSAGE(line);
+}
+
+static float priceFloat[BENCH_INPUTS];
+static Dec priceDec[BENCH_INPUTS];
+
+static void bench_parse() {
+  uint32_t f = benchRun([](uint8_t i) { priceFloat[i] = strtof(PRICE_TEXT[i], nullptr); });
+  uint32_t d = benchRun([](uint8_t i) { decParse(PRICE_TEXT[i], priceDec[i]); });
+  benchReport("parse", f, d);
+  for (uint8_t i = 0; i < BENCH_INPUTS; i++) {
+    TEST_ASSERT_FALSE(priceDec[i] == 0);
+  }
+}
+
+static void bench_body() {
+  uint32_t f = benchRun([](uint8_t i) {
+    StaticJsonDocument<256> doc;
+    if (!deserializeJson(doc, PRICE_BODY[i])) priceFloat[i] = doc["price"].as<float>();
+  });
+  uint32_t d = benchRun([](uint8_t i) { scanDec(PRICE_BODY[i], "price", priceDec[i]); });
+  benchReport("body", f, d);
+  for (uint8_t i = 0; i < BENCH_INPUTS; i++) {
+    TEST_ASSERT_FALSE(priceDec[i] == 0);
+  }
+}
+
+static void bench_price() {
+  uint32_t f = benchRun([](uint8_t i) {
+    char buf[24];
+    floatFormatPrice(buf, sizeof(buf), priceFloat[i], PRICE_DECIMALS[i]);
+    sink += buf[1];
+  });
+  uint32_t d = benchRun([](uint8_t i) {
+    char buf[24];
+    formatPrice(buf, sizeof(buf), priceDec[i], PRICE_DECIMALS[i]);
+    sink += buf[1];
+  });
+  benchReport("price", f, d);
+}
+
+static void bench_holding() {
+  static const float AMOUNT_FLOAT = 0.125f;
+  static const float BUY_FLOAT = 3000.0f;
+  static const Dec AMOUNT = decFromDouble(0.125);
+  static const Dec BUY = decFromDouble(3000.0);
+  uint32_t f = benchRun([](uint8_t i) {
+    char pl[24], pct[16];
+    float cost = BUY_FLOAT * AMOUNT_FLOAT;
+    float plUsdt = priceFloat[i] * AMOUNT_FLOAT - cost;
+    floatFormatPL(pl, sizeof(pl), plUsdt);
+    floatFormatPercent(pct, sizeof(pct), plUsdt / cost * 100.0f);
+    sink += pl[2] + pct[1];
+  });
+  uint32_t d = benchRun([](uint8_t i) {
+    char pl[24], pct[16];
+    Dec cost = decMul(BUY, AMOUNT);
+    Dec plUsdt = decMul(priceDec[i], AMOUNT) - cost;
+    formatPL(pl, sizeof(pl), plUsdt);
+    formatPercent(pct, sizeof(pct), decDiv(plUsdt * 100, cost));
+    sink += pl[2] + pct[1];
+  });
+  benchReport("holding", f, d);
+}
+
+static int runTests() {
+  UNITY_BEGIN();
+  RUN_TEST(bench_parse);
+  RUN_TEST(bench_body);
+  RUN_TEST(bench_price);
+  RUN_TEST(bench_holding);
+  return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+  delay(2000);
+  runTests();
+}
+
+void loop() {}
+#else
+int main() {
+  return runTests();
+}
+#endif
@@ -0,0 +1,235 @@
+#include <unity.h>
+#include "Dec.h"
+
+void setUp() {}
+void tearDown() {}
+
+static Dec parsed(const char* s) {
+  Dec v = -1;
+  TEST_ASSERT_TRUE_MESSAGE(decParse(s, v), s);
+  return v;
+}
+
+static void test_parse_plain() {
+  TEST_ASSERT_EQUAL_INT64(12345600000LL, parsed("123.456"));
+  TEST_ASSERT_EQUAL_INT64(4200000000LL, parsed("42"));
+  TEST_ASSERT_EQUAL_INT64(50000000LL, parsed(".5"));
+  TEST_ASSERT_EQUAL_INT64(700000000LL, parsed("7."));
+  TEST_ASSERT_EQUAL_INT64(6512345678LL, parsed(" \"65.12345678\""));
+  TEST_ASSERT_EQUAL_INT64(999999999999999999LL, parsed("9999999999.99999999"));
+}
+
+static void test_parse_negative() {
+  TEST_ASSERT_EQUAL_INT64(-150000000LL, parsed("-1.5"));
+  TEST_ASSERT_EQUAL_INT64(-1LL, parsed("-0.00000001"));
+  TEST_ASSERT_EQUAL_INT64(250000000LL, parsed("+2.5"));
+  TEST_ASSERT_EQUAL_INT64(0LL, parsed("-0"));
+}
+
+static void test_parse_rounding() {
+  TEST_ASSERT_EQUAL_INT64(2LL, parsed("0.000000015"));
+  TEST_ASSERT_EQUAL_INT64(1LL, parsed("0.000000014999"));
+  TEST_ASSERT_EQUAL_INT64(-2LL, parsed("-0.000000015"));
+  TEST_ASSERT_EQUAL_INT64(100000000LL, parsed("0.999999995"));
+}
+
+static void test_parse_exponent() {
+  TEST_ASSERT_EQUAL_INT64(100000000000LL, parsed("1e3"));
+  TEST_ASSERT_EQUAL_INT64(15000000000LL, parsed("1.5E2"));
+  TEST_ASSERT_EQUAL_INT64(100000LL, parsed("1e-3"));
+  TEST_ASSERT_EQUAL_INT64(-250000LL, parsed("-2.5e-3"));
+  TEST_ASSERT_EQUAL_INT64(910000000000000000LL, parsed("9.1e9"));
+}
+
+static void test_parse_exponent_range() {
+  Dec v = 7;
+  TEST_ASSERT_FALSE(decParse("1e12", v));
+  TEST_ASSERT_FALSE(decParse("-1e12", v));
+  TEST_ASSERT_FALSE(decParse("9e30", v));
+  TEST_ASSERT_FALSE(decParse("1e999", v));
+  TEST_ASSERT_FALSE(decParse("9.2e10", v));
+  TEST_ASSERT_EQUAL_INT64(7LL, v);
+}
+
+static void test_parse_overflow() {
+  Dec v = 7;
+  TEST_ASSERT_FALSE(decParse("12345678901", v));
+  TEST_ASSERT_FALSE(decParse("-99999999999.5", v));
+  TEST_ASSERT_EQUAL_INT64(7LL, v);
+}
+
+static void test_parse_garbage() {
+  Dec v = 7;
+  TEST_ASSERT_FALSE(decParse("", v));
+  TEST_ASSERT_FALSE(decParse("abc", v));
+  TEST_ASSERT_FALSE(decParse("-", v));
+  TEST_ASSERT_FALSE(decParse(".", v));
+  TEST_ASSERT_FALSE(decParse("\"\"", v));
+  TEST_ASSERT_FALSE(decParse("null", v));
+  TEST_ASSERT_FALSE(decParse("e5", v));
+  TEST_ASSERT_EQUAL_INT64(7LL, v);
+  TEST_ASSERT_EQUAL_INT64(1200000000LL, parsed("12abc"));
+}
+
+static void test_scan() {
+  Dec v = 7;
+  TEST_ASSERT_TRUE(scanDec("{\"symbol\":\"BTCUSDT\",\"price\":\"104523.45\"}", "price", v));
+  TEST_ASSERT_EQUAL_INT64(10452345000000LL, v);
+  TEST_ASSERT_TRUE(scanDec("{\"lastPrice\":\"1\", \"price\" : 2.5}", "price", v));
+  TEST_ASSERT_EQUAL_INT64(250000000LL, v);
+  v = 7;
+  TEST_ASSERT_FALSE(scanDec("{\"symbol\":\"price\"}", "price", v));
+  TEST_ASSERT_FALSE(scanDec("{\"price\":null}", "price", v));
+  TEST_ASSERT_FALSE(scanDec("{\"price\":", "price", v));
+  TEST_ASSERT_FALSE(scanDec("", "price", v));
+  TEST_ASSERT_EQUAL_INT64(7LL, v);
+}
+
+static void test_mul() {
+  TEST_ASSERT_EQUAL_INT64(300000000LL, decMul(150000000LL, 200000000LL));
+  TEST_ASSERT_EQUAL_INT64(-300000000LL, decMul(-150000000LL, 200000000LL));
+  TEST_ASSERT_EQUAL_INT64(300000000LL, decMul(-150000000LL, -200000000LL));
+  TEST_ASSERT_EQUAL_INT64(0LL, decMul(0LL, 6500000000000LL));
+  TEST_ASSERT_EQUAL_INT64(1LL, decMul(1LL, 50000000LL));
+  TEST_ASSERT_EQUAL_INT64(0LL, decMul(1LL, 49999999LL));
+  TEST_ASSERT_EQUAL_INT64(-1LL, decMul(-1LL, 50000000LL));
+  TEST_ASSERT_EQUAL_INT64(22750043209873LL, decMul(6500012345678LL, 350000000LL));
+  TEST_ASSERT_EQUAL_INT64(1000000000000000000LL, decMul(1000000000000000LL, 100000000000LL));
+}
+
+static void test_div() {
+  TEST_ASSERT_EQUAL_INT64(33333333LL, decDiv(100000000LL, 300000000LL));
+  TEST_ASSERT_EQUAL_INT64(66666667LL, decDiv(200000000LL, 300000000LL));
+  TEST_ASSERT_EQUAL_INT64(-66666667LL, decDiv(-200000000LL, 300000000LL));
+  TEST_ASSERT_EQUAL_INT64(66666667LL, decDiv(-200000000LL, -300000000LL));
+  TEST_ASSERT_EQUAL_INT64(250000000LL, decDiv(500000000LL, 200000000LL));
+  TEST_ASSERT_EQUAL_INT64(0LL, decDiv(500000000LL, 0LL));
+  TEST_ASSERT_EQUAL_INT64(-1250000000LL, decDiv(-250000000LL * 100, 2000000000LL));
+}
+
+static void assertFormat(const char* expect, Dec v, uint8_t d, char sep = 0) {
+  char buf[32];
+  size_t n = decFormat(buf, sizeof(buf), v, d, sep);
+  TEST_ASSERT_EQUAL_STRING(expect, buf);
+  TEST_ASSERT_EQUAL(strlen(expect), n);
+}
+
+static void test_format() {
+  assertFormat("1234567.89", decFromDouble(1234567.891), 2);
+  assertFormat("1,234,567.89", decFromDouble(1234567.891), 2, ',');
+  assertFormat("100", decFromDouble(100), 0, ',');
+  assertFormat("1,000", decFromDouble(1000), 0, ',');
+  assertFormat("0.00000001", 1LL, 8);
+  assertFormat("0.00000001", 1LL, 12);
+  assertFormat("92233720368.54775807", INT64_MAX, 8);
+}
+
+static void test_format_rounding() {
+  assertFormat("0.01", decFromDouble(0.005), 2);
+  assertFormat("0.00", decFromDouble(0.004), 2);
+  assertFormat("1235", decFromDouble(1234.5), 0);
+  assertFormat("10.00", decFromDouble(9.995), 2);
+  assertFormat("1,000.0", decFromDouble(999.95), 1, ',');
+}
+
+static void test_format_negative() {
+  assertFormat("-1.01", decFromDouble(-1.005), 2);
+  assertFormat("-1,234.50", decFromDouble(-1234.5), 2, ',');
+  assertFormat("0.00", decFromDouble(-0.004), 2);
+  assertFormat("-0.00000001", -1LL, 8);
+  assertFormat("-92233720368.54775808", INT64_MIN, 8);
+}
+
+static void test_format_truncate() {
+  char buf[4];
+  TEST_ASSERT_EQUAL(3, decFormat(buf, sizeof(buf), decFromDouble(123.45), 2));
+  TEST_ASSERT_EQUAL_STRING("123", buf);
+  TEST_ASSERT_EQUAL(0, decFormat(buf, 1, decFromDouble(1), 2));
+  TEST_ASSERT_EQUAL_STRING("", buf);
+}
+
+static void test_format_price() {
+  char buf[24];
+  formatPrice(buf, sizeof(buf), decFromDouble(104523.456), 2);
+  TEST_ASSERT_EQUAL_STRING("$104,523.46", buf);
+  formatPrice(buf, sizeof(buf), decFromDouble(0.00001234), 8);
+  TEST_ASSERT_EQUAL_STRING("$0.000012", buf);
+  formatPL(buf, sizeof(buf), decFromDouble(-1234.5));
+  TEST_ASSERT_EQUAL_STRING("-$1,234.50", buf);
+  formatPL(buf, sizeof(buf), decFromDouble(-0.004));
+  TEST_ASSERT_EQUAL_STRING("-$0.00", buf);
+  formatPL(buf, sizeof(buf), 0);
+  TEST_ASSERT_EQUAL_STRING("+$0.00", buf);
+}
+
+static void test_format_percent() {
+  char buf[16];
+  formatPercent(buf, sizeof(buf), decFromDouble(12.345));
+  TEST_ASSERT_EQUAL_STRING("+12.35%", buf);
+  formatPercent(buf, sizeof(buf), 0);
+  TEST_ASSERT_EQUAL_STRING("+0.00%", buf);
+  formatPercent(buf, sizeof(buf), decFromDouble(-5.5));
+  TEST_ASSERT_EQUAL_STRING("-5.50%", buf);
+  formatPercent(buf, sizeof(buf), decFromDouble(-0.004));
+  TEST_ASSERT_EQUAL_STRING("-0.00%", buf);
+  formatPercent(buf, sizeof(buf), decFromDouble(-0.005));
+  TEST_ASSERT_EQUAL_STRING("-0.01%", buf);
+  formatPercent(buf, sizeof(buf), -1LL);
+  TEST_ASSERT_EQUAL_STRING("-0.00%", buf);
+}
+
+static void test_format_no_fit() {
+  char buf[16];
+  formatPercent(buf, 8, decFromDouble(-12.5));
+  TEST_ASSERT_EQUAL_STRING("-12.50%", buf);
+  formatPercent(buf, 7, decFromDouble(-12.5));
+  TEST_ASSERT_EQUAL_STRING("", buf);
+  formatPercent(buf, 1, decFromDouble(1));
+  TEST_ASSERT_EQUAL_STRING("", buf);
+  formatPL(buf, 10, decFromDouble(-1234.5));
+  TEST_ASSERT_EQUAL_STRING("", buf);
+  formatPL(buf, 11, decFromDouble(-1234.5));
+  TEST_ASSERT_EQUAL_STRING("-$1,234.50", buf);
+  formatPrice(buf, 8, decFromDouble(104523.45), 2);
+  TEST_ASSERT_EQUAL_STRING("", buf);
+  buf[0] = 'x';
+  formatPrice(buf, 0, decFromDouble(1), 2);
+  TEST_ASSERT_EQUAL('x', buf[0]);
+}
+
+static int runTests() {
+  UNITY_BEGIN();
+  RUN_TEST(test_parse_plain);
+  RUN_TEST(test_parse_negative);
+  RUN_TEST(test_parse_rounding);
+  RUN_TEST(test_parse_exponent);
+  RUN_TEST(test_parse_exponent_range);
+  RUN_TEST(test_parse_overflow);
+  RUN_TEST(test_parse_garbage);
+  RUN_TEST(test_scan);
+  RUN_TEST(test_mul);
+  RUN_TEST(test_div);
+  RUN_TEST(test_format);
+  RUN_TEST(test_format_rounding);
+  RUN_TEST(test_format_negative);
+  RUN_TEST(test_format_truncate);
+  RUN_TEST(test_format_price);
+  RUN_TEST(test_format_percent);
+  RUN_TEST(test_format_no_fit);
+  return UNITY_END();
+}
+
+#ifdef ARDUINO
+#include <Arduino.h>
+
+void setup() {
+  delay(2000);
+  runTests();
+}
+
+void loop() {}
+#else
+int main() {
+  return runTests();
+}
+#endif